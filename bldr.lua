@@ -1,17 +1,24 @@
+if Project "nms-core" then
+    Compile "src/nms-core/**"
+    Include "src"
+    Import "nova"
+end
+
 if Project "nms-search" then
     Compile { "src/nms-search/**" }
     Include "src"
     Import {
         "nova",
         "glfw",
-        "index",
+        "nms-core",
     }
     Artifact { "out/nms-search", type = "Window" }
 end
 
 if Project "nms-index" then
     Compile "src/nms-index/**"
-    Import { "nova", "index" }
+    Include "src"
+    Import { "nova", "nms-core" }
     Artifact { "out/nms-index", type = "Console" }
 end
 
@@ -19,4 +26,25 @@ if Project "nms-launch" then
     Compile "src/nms-launch/**"
     Import { "nova" }
     Artifact { "out/nms-launch", type = "Window" }
-end
\ No newline at end of file
+end
+
+if Project "nms-searchd" then
+    Compile "src/nms-searchd/**"
+    Include "src"
+    Import { "nova", "nms-core" }
+    Artifact { "out/nms-searchd", type = "Console" }
+end
+
+if Project "nms-query" then
+    Compile "src/nms-query/**"
+    Include "src"
+    Import { "nova", "nms-core" }
+    Artifact { "out/nms-query", type = "Console" }
+end
+
+if Project "nms-bench" then
+    Compile "src/nms-bench/**"
+    Include "src"
+    Import { "nova", "nms-core" }
+    Artifact { "out/nms-bench", type = "Console" }
+end
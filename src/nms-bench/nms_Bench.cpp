@@ -0,0 +1,653 @@
+#include <nms-core/nms_Index.hpp>
+#include <nms-core/nms_MetadataFilter.hpp>
+#include <nms-core/nms_Searcher.hpp>
+#include <nms-core/nms_Parallel.hpp>
+#include <nms-core/nms_Memory.hpp>
+
+#include <nova/core/nova_Debug.hpp>
+#include <nova/core/nova_Guards.hpp>
+
+using namespace nova::types;
+
+// -----------------------------------------------------------------------------
+//                             Synthetic indexes
+// -----------------------------------------------------------------------------
+
+// Builds a deterministic tree with a realistic mix of repeated and unique names,
+// roughly one directory per eight entries and depths up to a dozen levels.
+// File sizes are log-uniform up to 4 GiB, times spread over three years.
+static constexpr u32 BenchTime = 1'700'000'000;
+
+static void GenerateIndex(nms::Index& index, u64 count, u64 seed = 1)
+{
+    static constexpr std::string_view CommonNames[] = {
+        "index.js", "README.md", "__init__.py", "package.json", "LICENSE",
+        "main.cpp", "CMakeLists.txt", ".gitignore", "Makefile", "config.yml",
+        "src", "include", "lib", "test", "docs", "build", "node_modules", ".git",
+    };
+
+    std::mt19937_64 rng(seed);
+
+    index.Clear();
+    index.root = "/bench";
+    index.parents.reserve(count);
+    index.nameOffsets.reserve(count + 1);
+    index.names.reserve(count * 14);
+    index.depths.reserve(count);
+    index.flags.reserve(count);
+    index.sizes.reserve(count);
+    index.modifiedTimes.reserve(count);
+    index.attributes.reserve(count);
+
+    std::vector<u32> directories;
+    std::string name;
+    while (index.Size() < count)
+    {
+        u32 parent = nms::InvalidEntry;
+        if (!directories.empty())
+        {
+            // Prefer recently created directories to build deeper trees
+            u64 window = std::min<u64>(directories.size(), 256);
+            parent = (rng() % 16 == 0)
+                ? directories[rng() % directories.size()]
+                : directories[directories.size() - 1 - rng() % window];
+            if (index.depths[parent] >= 12)
+                parent = directories[rng() % std::min<u64>(directories.size(), 64)];
+        }
+
+        bool directory = directories.empty() || rng() % 8 == 0;
+        if (rng() % 3 == 0)
+        {
+            name = CommonNames[rng() % std::size(CommonNames)];
+        }
+        else
+        {
+            name.clear();
+            u32 length = 4 + u32(rng() % 16);
+            for (u32 i = 0; i < length; ++i)
+                name += "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"[rng() % 63];
+            if (!directory)
+                name += ".dat";
+        }
+
+        nms::EntryMetadata metadata;
+        if (!directory)
+            metadata.size = rng() & ((1ull << (rng() % 33)) - 1);
+        metadata.modified = BenchTime - u32(rng() % (3 * 365 * 24 * 60 * 60));
+
+        u32 entry = index.AddEntry(parent, name, directory ? nms::EntryFlags::Directory : u8(0), metadata);
+        if (directory)
+            directories.push_back(entry);
+    }
+}
+
+static bool IsSorted(const nms::Index& index)
+{
+    for (u32 entry = 0; entry < index.Size(); ++entry)
+    {
+        u32 parent = index.parents[entry];
+        if (parent != nms::InvalidEntry && parent >= entry)
+            return false;
+
+        if (entry > 0)
+        {
+            if (index.depths[entry - 1] != index.depths[entry])
+            {
+                if (index.depths[entry - 1] > index.depths[entry])
+                    return false;
+            }
+            else if (nms::CompareFolded(index.GetName(entry - 1), index.GetName(entry)) > 0)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<class Fn>
+static f64 TimeMillis(Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// -----------------------------------------------------------------------------
+//                                Benchmarks
+// -----------------------------------------------------------------------------
+
+static void BenchSort(nova::Span<u64> sizes)
+{
+    u32 cores = nms::GetWorkerCount();
+    NOVA_LOG("sort_index: {} cores", cores);
+    NOVA_LOG("  {:>10} {:>8} {:>12} {:>14} {:>8}", "entries", "threads", "time (ms)", "Mentries/s", "sorted");
+
+    for (u64 size : sizes)
+    {
+        for (u32 threads : { 1u, cores })
+        {
+            nms::Index index;
+            GenerateIndex(index, size);
+
+            nms::SetWorkerCount(threads);
+            f64 ms = TimeMillis([&] { nms::SortIndex(index); });
+            nms::SetWorkerCount(0);
+
+            NOVA_LOG("  {:>10} {:>8} {:>12.1f} {:>14.2f} {:>8}",
+                size, threads, ms, f64(size) / ms / 1000.0, IsSorted(index) ? "yes" : "NO");
+
+            if (cores == 1)
+                break;
+        }
+    }
+}
+
+static void BenchMetadata(nova::Span<u64> sizes)
+{
+    NOVA_LOG("metadata filter: size:>1MB modified:<30d, {} fixed bytes per entry", nms::Index::EntryBytes);
+    NOVA_LOG("  {:>10} {:>14} {:>14} {:>10}", "entries", "scan (ms)", "per entry (ms)", "matches");
+
+    for (u64 size : sizes)
+    {
+        nms::Index index;
+        GenerateIndex(index, size);
+
+        nms::MetadataFilter filter;
+        std::string_view keywords[] = { "size:>1MB", "modified:<30d" };
+        for (auto keyword : keywords)
+            filter.Parse(keyword, BenchTime);
+
+        std::vector<u8> matched(index.Size());
+        f64 scanMs = TimeMillis([&] { filter.Scan(index, 0, index.Size(), matched.data()); });
+        u64 scanMatches = std::ranges::count(matched, u8(1));
+
+        u64 entryMatches = 0;
+        f64 entryMs = TimeMillis([&] {
+            for (u32 entry = 0; entry < index.Size(); ++entry)
+                entryMatches += filter.Matches(index, entry);
+        });
+
+        NOVA_LOG("  {:>10} {:>14.2f} {:>14.2f} {:>10}{}",
+            size, scanMs, entryMs, scanMatches, scanMatches == entryMatches ? "" : " MISMATCH");
+    }
+}
+
+static void BenchFuzzy(nova::Span<u64> sizes)
+{
+    static constexpr std::string_view Queries[] = { "~rdmd", "~cmklst", "~initpy", "~qzx9", "~abcdefgh" };
+
+    u32 cores = nms::GetWorkerCount();
+    NOVA_LOG("fuzzy filter: {} cores", cores);
+    NOVA_LOG("  {:>10} {:>12} {:>8} {:>12} {:>14} {:>10}", "entries", "query", "threads", "time (ms)", "Mentries/s", "matches");
+
+    for (u64 size : sizes)
+    {
+        nms::Index index;
+        GenerateIndex(index, size);
+        nms::SortIndex(index);
+
+        nms::Searcher searcher;
+        searcher.SetIndex(index);
+
+        for (auto query : Queries)
+        {
+            for (u32 threads : { 1u, cores })
+            {
+                nms::SetWorkerCount(threads);
+                f64 ms = TimeMillis([&] { searcher.Filter({ &query, 1 }); });
+                nms::SetWorkerCount(0);
+
+                u64 matches = 0;
+                for (u32 entry = searcher.FindNext(nms::InvalidEntry); entry != nms::InvalidEntry; entry = searcher.FindNext(entry))
+                    matches++;
+
+                NOVA_LOG("  {:>10} {:>12} {:>8} {:>12.1f} {:>14.2f} {:>10}",
+                    size, query, threads, ms, f64(size) / ms / 1000.0, matches);
+
+                if (cores == 1)
+                    break;
+            }
+        }
+    }
+}
+
+static void BenchAcronym(nova::Span<u64> sizes)
+{
+    // Initials typed as an acronym keyword, and the same letters as the
+    // fuzzy keyword that would otherwise be used to find them
+    static constexpr std::string_view Initials[] = { "ip", "cml", "rmd", "qzx" };
+
+    NOVA_LOG("acronym filter: {} cores", nms::GetWorkerCount());
+    NOVA_LOG("  {:>10} {:>10} {:>12} {:>12} {:>10} {:>10}", "entries", "initials", "ac: (ms)", "~ (ms)", "ac: hits", "~ hits");
+
+    for (u64 size : sizes)
+    {
+        nms::Index index;
+        GenerateIndex(index, size);
+        nms::SortIndex(index);
+
+        nms::Searcher searcher;
+        searcher.SetIndex(index);
+
+        auto run = [&](const std::string& keyword, u64& matches) {
+            std::string_view query = keyword;
+            f64 ms = TimeMillis([&] { searcher.Filter({ &query, 1 }); });
+            matches = 0;
+            for (u32 entry = searcher.FindNext(nms::InvalidEntry); entry != nms::InvalidEntry; entry = searcher.FindNext(entry))
+                matches++;
+            return ms;
+        };
+
+        for (auto initials : Initials)
+        {
+            u64 acronymMatches, fuzzyMatches;
+            f64 acronymMs = run(std::string(nms::AcronymPrefix) + std::string(initials), acronymMatches);
+            f64 fuzzyMs = run(nms::FuzzyPrefix + std::string(initials), fuzzyMatches);
+
+            NOVA_LOG("  {:>10} {:>10} {:>12.1f} {:>12.1f} {:>10} {:>10}",
+                size, initials, acronymMs, fuzzyMs, acronymMatches, fuzzyMatches);
+        }
+    }
+}
+
+static void BenchRegex(nova::Span<u64> sizes)
+{
+    // Regex keywords next to the plain keyword holding their literals, the
+    // last has only a short literal to prefilter with
+    static constexpr std::pair<std::string_view, std::string_view> Queries[] = {
+        { "re:^__init__\\.py$",       "__init__.py"  },
+        { "re:^package\\.(json|lock)", "package."     },
+        { "re:^read(me)?\\.md$",       "readme"       },
+        { "re:^[a-z]{4}\\d+\\.dat$",   ".dat"         },
+    };
+
+    NOVA_LOG("regex filter: {} cores", nms::GetWorkerCount());
+    NOVA_LOG("  {:>10} {:>26} {:>10} {:>12} {:>10} {:>10}", "entries", "regex", "re: (ms)", "plain (ms)", "re: hits", "hits");
+
+    for (u64 size : sizes)
+    {
+        nms::Index index;
+        GenerateIndex(index, size);
+        nms::SortIndex(index);
+
+        nms::Searcher searcher;
+        searcher.SetIndex(index);
+
+        auto run = [&](std::string_view query, u64& matches) {
+            f64 ms = TimeMillis([&] { searcher.Filter({ &query, 1 }); });
+            matches = 0;
+            for (u32 entry = searcher.FindNext(nms::InvalidEntry); entry != nms::InvalidEntry; entry = searcher.FindNext(entry))
+                matches++;
+            return ms;
+        };
+
+        for (auto [regex, plain] : Queries)
+        {
+            u64 regexMatches, plainMatches;
+            f64 regexMs = run(regex, regexMatches);
+            f64 plainMs = run(plain, plainMatches);
+
+            NOVA_LOG("  {:>10} {:>26} {:>10.1f} {:>12.1f} {:>10} {:>10}",
+                size, regex, regexMs, plainMs, regexMatches, plainMatches);
+        }
+    }
+}
+
+static void BenchName(nova::Span<u64> sizes)
+{
+    // Name lookups next to the anchored regex matching the same names
+    static constexpr std::pair<std::string_view, std::string_view> Queries[] = {
+        { "name:__init__.py", "re:^__init__\\.py$" },
+        { "name:readme.md",   "re:^readme\\.md$"   },
+        { "name^package.",    "re:^package\\."     },
+        { "name^qzx",         "re:^qzx"            },
+    };
+
+    NOVA_LOG("name lookup: {} cores", nms::GetWorkerCount());
+    NOVA_LOG("  {:>10} {:>18} {:>12} {:>10} {:>12} {:>10}", "entries", "lookup", "name (ms)", "re: (ms)", "name hits", "re: hits");
+
+    for (u64 size : sizes)
+    {
+        nms::Index index;
+        GenerateIndex(index, size);
+        nms::SortIndex(index);
+
+        nms::Searcher searcher;
+        searcher.SetIndex(index);
+
+        auto run = [&](std::string_view query, u64& matches) {
+            f64 ms = TimeMillis([&] { searcher.Filter({ &query, 1 }); });
+            matches = 0;
+            for (u32 entry = searcher.FindNext(nms::InvalidEntry); entry != nms::InvalidEntry; entry = searcher.FindNext(entry))
+                matches++;
+            return ms;
+        };
+
+        for (auto [name, regex] : Queries)
+        {
+            u64 nameMatches, regexMatches;
+            f64 nameMs = run(name, nameMatches);
+            f64 regexMs = run(regex, regexMatches);
+
+            NOVA_LOG("  {:>10} {:>18} {:>12.2f} {:>10.1f} {:>12} {:>10}",
+                size, name, nameMs, regexMs, nameMatches, regexMatches);
+        }
+    }
+}
+
+static void BenchScope(nova::Span<u64> sizes)
+{
+    // Scopes of shrinking subtrees, against the same directory as a plain
+    // path keyword, which every entry tests
+    static constexpr u64 Fractions[] = { 10, 100, 1000, 10000 };
+
+    NOVA_LOG("scope filter: {} cores", nms::GetWorkerCount());
+    NOVA_LOG("  {:>10} {:>12} {:>10} {:>12} {:>10} {:>10}", "entries", "descendants", "in: (ms)", "plain (ms)", "in: hits", "hits");
+
+    for (u64 size : sizes)
+    {
+        nms::Index index;
+        GenerateIndex(index, size);
+        nms::SortIndex(index);
+
+        nms::Searcher searcher;
+        searcher.SetIndex(index);
+
+        auto run = [&](std::vector<std::string_view> query, u64& matches) {
+            f64 ms = TimeMillis([&] { searcher.Filter({ query.data(), query.size() }); });
+            matches = 0;
+            for (u32 entry = searcher.FindNext(nms::InvalidEntry); entry != nms::InvalidEntry; entry = searcher.FindNext(entry))
+                matches++;
+            return ms;
+        };
+
+        for (u64 fraction : Fractions)
+        {
+            // Directory whose subtree is closest to the fraction of the index
+            u32 directory = nms::InvalidEntry;
+            u64 target = size / fraction;
+            u64 best = UINT64_MAX;
+            for (u32 entry = 0; entry < index.Size(); ++entry)
+            {
+                if (!index.IsDirectory(entry))
+                    continue;
+                u64 descendants = index.GetDescendants(entry).size();
+                u64 distance = descendants > target ? descendants - target : target - descendants;
+                if (distance < best)
+                {
+                    best = distance;
+                    directory = entry;
+                }
+            }
+
+            auto path = index.GetFullPath(directory);
+            auto scope = "in:" + path;
+            auto plain = path + "/";
+
+            u64 scopeMatches, plainMatches;
+            f64 scopeMs = run({ scope, "readme" }, scopeMatches);
+            f64 plainMs = run({ plain, "readme" }, plainMatches);
+
+            NOVA_LOG("  {:>10} {:>12} {:>10.2f} {:>12.1f} {:>10} {:>10}",
+                size, index.GetDescendants(directory).size(), scopeMs, plainMs, scopeMatches, plainMatches);
+        }
+    }
+}
+
+static void BenchPool(nova::Span<u64> sizes)
+{
+    static constexpr std::string_view Query = "~initpy";
+    static constexpr u32 Runs = 5;
+
+    auto& pool = nms::GetThreadPool();
+    NOVA_LOG("pool: {} workers", pool.Size());
+    NOVA_LOG("  {:>10} {:>12} {:>12} {:>16}", "entries", "load", "priority", "median (ms)");
+
+    for (u64 size : sizes)
+    {
+        nms::Index index;
+        GenerateIndex(index, size);
+        nms::SortIndex(index);
+
+        nms::Searcher searcher;
+        searcher.SetIndex(index);
+
+        auto measure = [&](std::string_view load, nms::TaskPriority priority, std::string_view name) {
+            nms::TaskPriorityScope scope(priority);
+            std::array<f64, Runs> times;
+            for (auto& time : times)
+                time = TimeMillis([&] { searcher.Filter({ &Query, 1 }); });
+            std::ranges::sort(times);
+            NOVA_LOG("  {:>10} {:>12} {:>12} {:>16.1f}", size, load, name, times[Runs / 2]);
+        };
+
+        measure("idle", nms::TaskPriority::Interactive, "interactive");
+
+        // Saturate the pool with short background tasks, like icon decodes
+        // and index maintenance, then filter at both ends of the queue
+
+        std::atomic<bool> stop = false;
+        nms::TaskGroup background;
+        for (u32 i = 0; i < pool.Size() * 256; ++i)
+        {
+            background.Run(nms::TaskPriority::Background, [&stop] {
+                auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(2);
+                while (!stop && std::chrono::steady_clock::now() < end);
+            });
+        }
+
+        measure("background", nms::TaskPriority::Interactive, "interactive");
+        measure("background", nms::TaskPriority::Background, "background");
+
+        stop = true;
+        background.Wait();
+    }
+
+    pool.LogStats();
+}
+
+static void BenchGroups(nova::Span<u64> sizes)
+{
+    // Short lived groups, destroyed as soon as Wait returns, as ParallelFor
+    // and the search front end use them. Groups live on the heap so that a
+    // task still touching one after Wait shows up under a sanitizer.
+    static constexpr u32 TasksPerGroup = 4;
+
+    NOVA_LOG("task groups: {} workers", nms::GetThreadPool().Size());
+    NOVA_LOG("  {:>10} {:>12} {:>14} {:>10}", "groups", "time (ms)", "per group (us)", "tasks ok");
+
+    for (u64 size : sizes)
+    {
+        std::atomic<u64> executed = 0;
+        f64 ms = TimeMillis([&] {
+            for (u64 i = 0; i < size; ++i)
+            {
+                auto group = std::make_unique<nms::TaskGroup>();
+                for (u32 t = 0; t < TasksPerGroup; ++t)
+                    group->Run([&] { executed.fetch_add(1, std::memory_order_relaxed); });
+                group->Wait();
+            }
+        });
+
+        bool ok = executed == size * TasksPerGroup;
+        NOVA_LOG("  {:>10} {:>12.1f} {:>14.3f} {:>10}", size, ms, ms * 1000.0 / f64(std::max<u64>(size, 1)), ok ? "yes" : "NO");
+    }
+}
+
+static void BenchLoad(nova::Span<u64> sizes)
+{
+    auto dir = std::filesystem::temp_directory_path() / "nms-bench";
+    std::filesystem::create_directories(dir);
+    NOVA_DEFER(&) {
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    };
+
+    NOVA_LOG("load_index: {} cores", nms::GetWorkerCount());
+    NOVA_LOG("  {:>10} {:>8} {:>12} {:>12} {:>12} {:>12} {:>14}",
+        "entries", "encoding", "size (MiB)", "save (ms)", "cold (ms)", "warm (ms)", "1 block (us)");
+
+    for (u64 size : sizes)
+    {
+        nms::Index index;
+        GenerateIndex(index, size);
+        nms::SortIndex(index);
+
+        for (auto encoding : { nms::IndexEncoding::Raw, nms::IndexEncoding::Blocks })
+        {
+            bool blocks = encoding == nms::IndexEncoding::Blocks;
+            auto file = dir / (blocks ? "blocks.bin" : "raw.bin");
+            f64 saveMs = TimeMillis([&] { nms::SaveIndex(index, file, encoding); });
+
+            nms::Index loaded;
+            nms::DropFileCache(file);
+            f64 coldMs = TimeMillis([&] { nms::LoadIndex(loaded, file); });
+            f64 warmMs = TimeMillis([&] { nms::LoadIndex(loaded, file); });
+
+            if (loaded.names != index.names || loaded.parents != index.parents || loaded.sizes != index.sizes)
+                NOVA_LOG("  MISMATCH after loading {}", file.string());
+
+            f64 blockUs = 0;
+            if (blocks)
+            {
+                nms::IndexBlockReader reader(file);
+                std::vector<u8> block;
+                blockUs = TimeMillis([&] { reader.ReadBlock(reader.GetBlockCount() / 2, block); }) * 1000.0;
+            }
+
+            NOVA_LOG("  {:>10} {:>8} {:>12.1f} {:>12.1f} {:>12.1f} {:>12.1f} {:>14.1f}",
+                size, blocks ? "blocks" : "raw", f64(std::filesystem::file_size(file)) / (1024 * 1024),
+                saveMs, coldMs, warmMs, blockUs);
+        }
+    }
+}
+
+static void BenchArena(nova::Span<u64> sizes)
+{
+    static constexpr std::string_view Queries[] = { "qzx", "size:>1MB" };
+    static constexpr u32 Runs = 5;
+
+    auto dir = std::filesystem::temp_directory_path() / "nms-bench";
+    std::filesystem::create_directories(dir);
+    NOVA_DEFER(&) {
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    };
+
+    NOVA_LOG("arena scan: {} cores", nms::GetWorkerCount());
+    NOVA_LOG("  {:>10} {:>12} {:>12} {:>12} {:>14} {:>12}", "entries", "memory", "query", "median (ms)", "Mentries/s", "names GB/s");
+
+    for (u64 size : sizes)
+    {
+        nms::Index generated;
+        GenerateIndex(generated, size);
+        nms::SortIndex(generated);
+
+        auto file = dir / "arena.bin";
+        nms::SaveIndex(generated, file);
+
+        auto measure = [&](const nms::Index& index, std::string_view memory) {
+            nms::Searcher searcher;
+            searcher.SetIndex(index);
+
+            for (auto query : Queries)
+            {
+                std::array<f64, Runs> times;
+                for (auto& time : times)
+                    time = TimeMillis([&] { searcher.Filter({ &query, 1 }); });
+                std::ranges::sort(times);
+
+                f64 ms = times[Runs / 2];
+                NOVA_LOG("  {:>10} {:>12} {:>12} {:>12.2f} {:>14.1f} {:>12.2f}",
+                    size, memory, query, ms, f64(size) / ms / 1000.0, f64(index.names.size()) / ms / 1e6);
+            }
+        };
+
+        measure(generated, "heap");
+        generated.Clear();
+
+        for (bool hugePages : { false, true })
+        {
+            nms::SetHugePages(hugePages);
+
+            nms::Index loaded;
+            nms::LoadIndex(loaded, file);
+            measure(loaded, !hugePages ? "arena" : loaded.arena->HasHugePages() ? "arena+huge" : "arena (no THP)");
+        }
+        nms::SetHugePages(true);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string_view bench = argc > 1 ? argv[1] : "";
+
+    std::vector<u64> sizes;
+    for (i32 i = 2; i < argc; ++i)
+        sizes.push_back(u64(std::stod(argv[i]) * 1'000'000));
+
+    if (sizes.empty())
+        sizes = { 1'000'000, 10'000'000, 50'000'000 };
+
+    if (bench == "sort")
+    {
+        BenchSort(sizes);
+    }
+    else if (bench == "metadata")
+    {
+        BenchMetadata(sizes);
+    }
+    else if (bench == "fuzzy")
+    {
+        BenchFuzzy(sizes);
+    }
+    else if (bench == "acronym")
+    {
+        BenchAcronym(sizes);
+    }
+    else if (bench == "regex")
+    {
+        BenchRegex(sizes);
+    }
+    else if (bench == "name")
+    {
+        BenchName(sizes);
+    }
+    else if (bench == "scope")
+    {
+        BenchScope(sizes);
+    }
+    else if (bench == "pool")
+    {
+        BenchPool(sizes);
+    }
+    else if (bench == "groups")
+    {
+        BenchGroups(sizes);
+    }
+    else if (bench == "load")
+    {
+        BenchLoad(sizes);
+    }
+    else if (bench == "arena")
+    {
+        BenchArena(sizes);
+    }
+    else
+    {
+        NOVA_LOG("Usage: nms-bench <benchmark> [sizes in millions...]");
+        NOVA_LOG("  sort     Parallel sort_index");
+        NOVA_LOG("  metadata Metadata column scan against per entry tests");
+        NOVA_LOG("  fuzzy    Fuzzy subsequence filter latency");
+        NOVA_LOG("  acronym  Acronym keywords against fuzzy keywords for the same initials");
+        NOVA_LOG("  regex    Regex keywords against plain keywords for their literals");
+        NOVA_LOG("  name     Name lookups against anchored regex keywords");
+        NOVA_LOG("  scope    Scoped keywords against plain path keywords for the same directory");
+        NOVA_LOG("  pool     Interactive filter latency with the thread pool under background load");
+        NOVA_LOG("  groups   Creates and destroys short lived task groups, checking every task ran");
+        NOVA_LOG("  load     Index file size and cold load time, raw against block compressed");
+        NOVA_LOG("  arena    Scan throughput over heap columns, an arena, and an arena on huge pages");
+        return 1;
+    }
+}
@@ -0,0 +1,174 @@
+#include "nms_Acronyms.hpp"
+
+namespace nms
+{
+    namespace
+    {
+        enum class CharClass
+        {
+            NonWord,
+            Lower,
+            Upper,
+            Digit,
+        };
+
+        CharClass Classify(c8 c)
+        {
+            if (c >= 'a' && c <= 'z') return CharClass::Lower;
+            if (c >= 'A' && c <= 'Z') return CharClass::Upper;
+            if (c >= '0' && c <= '9') return CharClass::Digit;
+
+            // Bytes of multi-byte sequences count as word characters
+            if (u8(c) >= 0x80) return CharClass::Lower;
+
+            return CharClass::NonWord;
+        }
+
+        // Calls fn(i) for each byte i that starts a word. An uppercase run
+        // followed by lowercase ends one letter early, so "XMLHttp" reads as
+        // XML, Http.
+        template<class Fn>
+        void VisitWordStarts(std::string_view name, Fn&& fn)
+        {
+            CharClass prev = CharClass::NonWord;
+            for (usz i = 0; i < name.size(); ++i)
+            {
+                CharClass current = Classify(name[i]);
+                bool start = false;
+                switch (current)
+                {
+                break;case CharClass::NonWord:
+                    start = false;
+                break;case CharClass::Lower:
+                    start = prev == CharClass::NonWord || prev == CharClass::Digit;
+                break;case CharClass::Upper:
+                    start = prev != CharClass::Upper
+                        || (i + 1 < name.size() && Classify(name[i + 1]) == CharClass::Lower);
+                break;case CharClass::Digit:
+                    start = prev != CharClass::Digit;
+                }
+
+                if (start)
+                    fn(i);
+                prev = current;
+            }
+        }
+    }
+
+    u32 GetWordStarts(std::string_view name)
+    {
+        u32 starts = 0;
+        u32 initials = 0;
+        VisitWordStarts(name, [&](usz i) {
+            if (i < WordStartBits)
+                starts |= 1u << i;
+            initials++;
+        });
+
+        if (initials > PackedAcronymLength)
+            starts |= AcronymTruncated;
+        return starts;
+    }
+
+    u64 PackAcronym(std::string_view name)
+    {
+        u64 packed = 0;
+        u32 initials = 0;
+        VisitWordStarts(name, [&](usz i) {
+            if (initials < PackedAcronymLength)
+                packed |= u64(u8(FoldChar(name[i]))) << (initials * 8);
+            initials++;
+        });
+        return packed;
+    }
+
+    std::string GetAcronym(std::string_view name)
+    {
+        std::string acronym;
+        VisitWordStarts(name, [&](usz i) {
+            acronym.push_back(FoldChar(name[i]));
+        });
+        return acronym;
+    }
+
+// -----------------------------------------------------------------------------
+
+    AcronymPattern::AcronymPattern(std::string_view query)
+    {
+        folded.reserve(query.size());
+        for (c8 c : query)
+            folded.push_back(FoldChar(c));
+
+        if (folded.size() <= PackedAcronymLength)
+        {
+            for (usz i = 0; i < folded.size(); ++i)
+                broadcast[i] = 0x0101010101010101 * u8(folded[i]);
+        }
+    }
+
+    bool AcronymPattern::Matches(const Index& index, u32 entry) const
+    {
+        if (folded.empty())
+            return true;
+
+        if (folded.size() <= PackedAcronymLength && MatchesPacked(index.acronyms[entry], broadcast.data(), folded.size()))
+            return true;
+
+        u32 starts = index.wordStarts[entry];
+        if (!(starts & AcronymTruncated))
+            return false;
+
+        // Short names have every word start in the mask, longer ones are
+        // split again. Initials past the buffer are dropped, which takes a
+        // name of over 256 words.
+
+        std::array<c8, 256> buffer;
+        usz length = 0;
+        auto name = index.GetName(entry);
+        if (name.size() <= WordStartBits)
+        {
+            for (u32 bits = starts & ~AcronymTruncated; bits; bits &= bits - 1)
+                buffer[length++] = FoldChar(name[std::countr_zero(bits)]);
+        }
+        else
+        {
+            VisitWordStarts(name, [&](usz i) {
+                if (length < buffer.size())
+                    buffer[length++] = FoldChar(name[i]);
+            });
+        }
+
+        return std::string_view(buffer.data(), length).find(folded) != std::string_view::npos;
+    }
+
+    void AcronymPattern::Scan(const Index& index, u32 begin, u32 end, u8* matched) const
+    {
+        if (folded.empty())
+            return;
+
+        // Entries with truncated acronyms survive the packed pass, so the
+        // second pass can test their full acronym. The pattern is copied to
+        // locals, as stores through matched could alias members.
+
+        const u32* wordStarts = index.wordStarts.data();
+        if (folded.size() <= PackedAcronymLength)
+        {
+            const u64* acronyms = index.acronyms.data();
+            auto pattern = broadcast;
+            usz length = folded.size();
+            for (u32 entry = begin; entry < end; ++entry)
+                matched[entry] &= MatchesPacked(acronyms[entry], pattern.data(), length) | u8(wordStarts[entry] >> 31);
+        }
+        else
+        {
+            for (u32 entry = begin; entry < end; ++entry)
+                matched[entry] &= u8(wordStarts[entry] >> 31);
+        }
+
+        for (u32 entry = begin; entry < end; ++entry)
+        {
+            if (matched[entry] && (wordStarts[entry] & AcronymTruncated))
+                matched[entry] = Matches(index, entry);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "nms_Index.hpp"
+
+namespace nms
+{
+    // Names split into words at spaces and punctuation, at camelCase humps
+    // and where digits begin, so "PowerShell Script.ps1" reads as Power,
+    // Shell, Script, ps, 1. The folded initials of those words form the
+    // name's acronym, and "ac:pss" finds every name whose acronym contains
+    // "PSS".
+    //
+    // Indexes store the word starts and a packed acronym per entry, letting
+    // an acronym keyword test most entries with a few integer compares.
+
+    // Bit i is set when name byte i starts a word, for bytes below 31. The
+    // top bit flags names with more initials than a packed acronym holds.
+    constexpr u32 WordStartBits = 31;
+    constexpr u32 AcronymTruncated = 1u << 31;
+
+    u32 GetWordStarts(std::string_view name);
+
+    // The first PackedAcronymLength initials, folded, from the low byte up
+    // and zero padded
+    constexpr u32 PackedAcronymLength = 8;
+
+    u64 PackAcronym(std::string_view name);
+
+    // Every initial, folded
+    std::string GetAcronym(std::string_view name);
+
+    // Acronym keywords are written with a leading "ac:"
+    constexpr std::string_view AcronymPrefix = "ac:";
+
+    class AcronymPattern
+    {
+        std::string folded;
+
+        // Each character of a short pattern repeated across all eight bytes
+        std::array<u64, PackedAcronymLength> broadcast = {};
+
+    public:
+        explicit AcronymPattern(std::string_view query);
+
+        bool IsEmpty() const
+        {
+            return folded.empty();
+        }
+
+        bool Matches(const Index& index, u32 entry) const;
+
+        // Clears matched for entries in [begin, end) whose acronym does not
+        // contain the pattern. Like every scan kernel, matched is indexed by
+        // entry and only [begin, end) is touched. Packed acronyms are compared in a branch-free
+        // pass the compiler can vectorize, only truncated acronyms that miss
+        // are rebuilt from their names.
+        void Scan(const Index& index, u32 begin, u32 end, u8* matched) const;
+
+    private:
+        // High bit of every byte of word equal to the broadcast byte, exact
+        // for all byte values
+        static u64 EqualBytes(u64 word, u64 broadcast)
+        {
+            constexpr u64 Low7 = 0x7F7F7F7F7F7F7F7F;
+            constexpr u64 High = 0x8080808080808080;
+            u64 x = word ^ broadcast;
+            return ~(((x & Low7) + Low7) | x) & High;
+        }
+
+        // Tests every offset at once: the byte masks of each pattern
+        // character are shifted back by its position and intersected,
+        // leaving a bit where the whole pattern starts. Zero padding never
+        // matches, as names hold no zero bytes.
+        static u8 MatchesPacked(u64 acronym, const u64* broadcast, usz length)
+        {
+            u64 hits = EqualBytes(acronym, broadcast[0]);
+            for (usz i = 1; i < length; ++i)
+                hits &= EqualBytes(acronym, broadcast[i]) >> (i * 8);
+            return u8(hits != 0);
+        }
+    };
+}
@@ -0,0 +1,92 @@
+#include "nms_AhoCorasick.hpp"
+
+#include "nms_Index.hpp"
+
+namespace nms
+{
+    void AhoCorasick::Build(nova::Span<std::string> patterns)
+    {
+        // Byte classes, class 0 is every byte that appears in no pattern.
+        // Input is folded through the class table, so lower case letters
+        // share the class of their folded upper case counterpart.
+
+        classes.fill(0);
+        classCount = 1;
+        for (auto& pattern : patterns)
+        {
+            for (c8 c : pattern)
+            {
+                if (!classes[u8(c)])
+                    classes[u8(c)] = u8(classCount++);
+            }
+        }
+        for (u32 i = 0; i < 256; ++i)
+            classes[i] = classes[u8(FoldChar(c8(i)))];
+
+        // Trie
+
+        transitions.assign(classCount, 0);
+        outputs.assign(1, UINT32_MAX);
+        auto addState = [&] {
+            transitions.resize(transitions.size() + classCount, 0);
+            outputs.push_back(UINT32_MAX);
+            return u32(outputs.size() - 1);
+        };
+
+        for (u32 p = 0; p < patterns.size(); ++p)
+        {
+            u32 state = 0;
+            for (c8 c : patterns[p])
+            {
+                auto& next = transitions[usz(state) * classCount + classes[u8(c)]];
+                if (!next)
+                {
+                    u32 added = addState();
+                    transitions[usz(state) * classCount + classes[u8(c)]] = added;
+                    state = added;
+                }
+                else
+                {
+                    state = next;
+                }
+            }
+            outputs[state] = p;
+        }
+
+        // Breadth first fill of failure transitions and dictionary links
+
+        u32 stateCount = u32(outputs.size());
+        std::vector<u32> failures(stateCount, 0);
+        dictLinks.assign(stateCount, 0);
+
+        std::vector<u32> queue;
+        queue.reserve(stateCount);
+        for (u32 c = 0; c < classCount; ++c)
+        {
+            if (u32 next = transitions[c])
+                queue.push_back(next);
+        }
+
+        for (usz head = 0; head < queue.size(); ++head)
+        {
+            u32 state = queue[head];
+            u32 failure = failures[state];
+            dictLinks[state] = outputs[failure] != UINT32_MAX ? failure : dictLinks[failure];
+
+            for (u32 c = 0; c < classCount; ++c)
+            {
+                auto& next = transitions[usz(state) * classCount + c];
+                u32 fallback = transitions[usz(failure) * classCount + c];
+                if (next)
+                {
+                    failures[next] = fallback;
+                    queue.push_back(next);
+                }
+                else
+                {
+                    next = fallback;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <nova/core/nova_Core.hpp>
+
+using namespace nova::types;
+
+namespace nms
+{
+    // Multi-pattern matcher over case folded bytes. Transitions are stored as
+    // a dense table over the byte classes that occur in the patterns, which
+    // keeps the automaton small even for many thousands of patterns.
+
+    class AhoCorasick
+    {
+        std::array<u8, 256> classes = {};
+        u32 classCount = 1;
+
+        std::vector<u32> transitions;
+        std::vector<u32> outputs;    // Pattern ending at state, or UINT32_MAX
+        std::vector<u32> dictLinks;  // Next suffix state with an output, or 0
+
+    public:
+        // Patterns must already be case folded and unique
+        void Build(nova::Span<std::string> patterns);
+
+        // Calls fn(pattern) for every occurrence of every pattern in text
+        template<class Fn>
+        void Scan(std::string_view text, Fn&& fn) const
+        {
+            u32 state = 0;
+            for (c8 c : text)
+            {
+                state = transitions[usz(state) * classCount + classes[u8(c)]];
+                for (u32 s = outputs[state] != UINT32_MAX ? state : dictLinks[state]; s; s = dictLinks[s])
+                    fn(outputs[s]);
+            }
+        }
+
+        bool IsEmpty() const
+        {
+            return transitions.empty();
+        }
+    };
+}
@@ -0,0 +1,98 @@
+#include "nms_Arena.hpp"
+
+#ifdef _WIN32
+#  include <nova/core/win32/nova_Win32Include.hpp>
+#else
+#  include <sys/mman.h>
+#endif
+
+namespace nms
+{
+    namespace
+    {
+        std::atomic<bool> HugePagesEnabled = true;
+
+        // Transparent huge pages are only used for naturally aligned 2 MiB
+        // ranges
+        constexpr usz HugePageSize = 2 * 1024 * 1024;
+    }
+
+    void SetHugePages(bool enabled)
+    {
+        HugePagesEnabled = enabled;
+    }
+
+    bool GetHugePages()
+    {
+        return HugePagesEnabled;
+    }
+
+    Arena::Arena(usz _capacity, bool _hugePages)
+    {
+        if (!_capacity)
+            return;
+
+#ifdef _WIN32
+        // Large pages need the lock pages privilege, which user accounts do
+        // not hold by default, so Windows arenas always use regular pages
+        (void)_hugePages;
+        base = static_cast<u8*>(VirtualAlloc(nullptr, _capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+        if (!base)
+            throw std::runtime_error(NOVA_FORMAT("Failed to allocate arena of {} bytes", _capacity));
+        capacity = _capacity;
+#else
+        if (_hugePages)
+        {
+            // Map a huge page more than needed and trim both ends, leaving
+            // an aligned block made of whole huge pages
+            usz size = (_capacity + HugePageSize - 1) & ~(HugePageSize - 1);
+            void* mapping = mmap(nullptr, size + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED)
+                throw std::runtime_error(NOVA_FORMAT("Failed to map arena of {} bytes", size));
+
+            auto start = reinterpret_cast<uintptr_t>(mapping);
+            auto aligned = (start + HugePageSize - 1) & ~uintptr_t(HugePageSize - 1);
+            if (aligned > start)
+                munmap(mapping, aligned - start);
+            if (usz tail = HugePageSize - (aligned - start))
+                munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+            base = reinterpret_cast<u8*>(aligned);
+            capacity = size;
+            hugePages = madvise(base, capacity, MADV_HUGEPAGE) == 0;
+        }
+        else
+        {
+            void* mapping = mmap(nullptr, _capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED)
+                throw std::runtime_error(NOVA_FORMAT("Failed to map arena of {} bytes", _capacity));
+
+            base = static_cast<u8*>(mapping);
+            capacity = _capacity;
+        }
+#endif
+    }
+
+    Arena::~Arena()
+    {
+        if (!base)
+            return;
+
+#ifdef _WIN32
+        VirtualFree(base, 0, MEM_RELEASE);
+#else
+        munmap(base, capacity);
+#endif
+    }
+
+    void* Arena::Allocate(usz size, usz alignment)
+    {
+        alignment = std::max(alignment, Alignment);
+        usz offset = (used + alignment - 1) & ~(alignment - 1);
+        if (offset > capacity || size > capacity - offset)
+            return nullptr;
+
+        used = offset + size;
+        return base + offset;
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <nova/core/nova_Core.hpp>
+
+using namespace nova::types;
+
+namespace nms
+{
+    // One contiguous block of memory handed out front to back and released
+    // as a whole when the arena is destroyed. On Linux the block can be
+    // backed by transparent huge pages, which cuts TLB misses when scanning
+    // columns that span gigabytes.
+
+    class Arena
+    {
+        u8* base = nullptr;
+        usz capacity = 0;
+        usz used = 0;
+        bool hugePages = false;
+
+    public:
+        // Allocations start on cache lines, so columns never share one
+        static constexpr usz Alignment = 64;
+
+        Arena(usz capacity, bool hugePages);
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        // Null when the request does not fit, callers fall back to the heap.
+        // Not synchronised, an arena is filled from one thread at a time.
+        void* Allocate(usz size, usz alignment);
+
+        bool Owns(const void* pointer) const
+        {
+            auto bytes = static_cast<const u8*>(pointer);
+            return bytes >= base && bytes < base + capacity;
+        }
+
+        usz GetCapacity() const { return capacity; }
+        usz GetUsed() const { return used; }
+
+        // True if huge pages were requested and the kernel accepted the hint
+        bool HasHugePages() const { return hugePages; }
+    };
+
+    // Whether arenas created from now on ask for huge pages, on by default
+    void SetHugePages(bool enabled);
+    bool GetHugePages();
+
+// -----------------------------------------------------------------------------
+
+    // Allocates from an arena while it has room and from the heap otherwise.
+    // Arena memory is only reclaimed with the arena, which every container
+    // using it keeps alive. A default constructed allocator uses the heap.
+
+    template<class T>
+    class ArenaAllocator
+    {
+    public:
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        std::shared_ptr<Arena> arena;
+
+        ArenaAllocator() = default;
+
+        ArenaAllocator(std::shared_ptr<Arena> _arena)
+            : arena(std::move(_arena))
+        {}
+
+        template<class U>
+        ArenaAllocator(const ArenaAllocator<U>& other)
+            : arena(other.arena)
+        {}
+
+        T* allocate(usz count)
+        {
+            if (arena)
+            {
+                if (void* memory = arena->Allocate(count * sizeof(T), alignof(T)))
+                    return static_cast<T*>(memory);
+            }
+            return std::allocator<T>().allocate(count);
+        }
+
+        void deallocate(T* pointer, usz count)
+        {
+            if (!arena || !arena->Owns(pointer))
+                std::allocator<T>().deallocate(pointer, count);
+        }
+
+        // Copies never share the source's arena
+        ArenaAllocator select_on_container_copy_construction() const
+        {
+            return {};
+        }
+
+        template<class U>
+        bool operator==(const ArenaAllocator<U>& other) const
+        {
+            return arena == other.arena;
+        }
+    };
+
+    template<class T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+    using ArenaString = std::basic_string<c8, std::char_traits<c8>, ArenaAllocator<c8>>;
+}
@@ -0,0 +1,189 @@
+#include "nms_BatchSearch.hpp"
+
+#include "nms_AhoCorasick.hpp"
+#include "nms_MetadataFilter.hpp"
+#include "nms_Fuzzy.hpp"
+#include "nms_Parallel.hpp"
+
+namespace nms
+{
+    namespace
+    {
+        // Sorted, unique pattern ids
+        void InsertPattern(std::vector<u32>& set, u32 pattern)
+        {
+            auto pos = std::lower_bound(set.begin(), set.end(), pattern);
+            if (pos == set.end() || *pos != pattern)
+                set.insert(pos, pattern);
+        }
+
+        bool ContainsPattern(const std::vector<u32>& set, u32 pattern)
+        {
+            return std::binary_search(set.begin(), set.end(), pattern);
+        }
+    }
+
+    void BatchSearch(
+        const Index& index,
+        nova::Span<std::vector<std::string>> queries,
+        std::vector<std::vector<u32>>& results,
+        u32 limit)
+    {
+        results.assign(queries.size(), {});
+
+        // Intern folded keywords as patterns. Each query is listed against
+        // its first pattern only, so a hit triggers at most one check per query.
+
+        std::vector<std::string> patterns;
+        ankerl::unordered_dense::map<std::string, u32> patternIds;
+        std::vector<std::vector<u32>> queryPatterns(queries.size());
+        std::vector<std::vector<u32>> queriesByPattern;
+        std::vector<MetadataFilter> filters(queries.size());
+        std::vector<std::vector<FuzzyPattern>> fuzzy(queries.size());
+        bool spansSeparator = false;
+        u32 now = GetUnixTime();
+
+        for (u32 q = 0; q < queries.size(); ++q)
+        {
+            for (auto& keyword : queries[q])
+            {
+                if (keyword.empty() || filters[q].Parse(keyword, now))
+                    continue;
+
+                if (keyword.starts_with(FuzzyPrefix))
+                {
+                    if (keyword.size() > 1)
+                        fuzzy[q].emplace_back(std::string_view(keyword).substr(1));
+                    continue;
+                }
+
+                std::string folded = keyword;
+                for (auto& c : folded)
+                    c = FoldChar(c);
+
+                spansSeparator |= folded.find(PathSeparator) != std::string::npos;
+
+                auto [iter, inserted] = patternIds.try_emplace(folded, u32(patterns.size()));
+                if (inserted)
+                {
+                    patterns.push_back(std::move(folded));
+                    queriesByPattern.emplace_back();
+                }
+                InsertPattern(queryPatterns[q], iter->second);
+            }
+
+            if (!queryPatterns[q].empty())
+                queriesByPattern[queryPatterns[q][0]].push_back(q);
+        }
+
+        if (patterns.empty())
+            return;
+
+        AhoCorasick matcher;
+        matcher.Build(patterns);
+
+        u32 count = index.Size();
+
+        // Pass 1: Accumulate the pattern hits of every directory's full path.
+        // Parents precede children, so each directory extends its parent's set.
+        // Keywords spanning a separator can only be matched on full paths.
+
+        std::vector<u32> dirSets(count, UINT32_MAX);
+        std::vector<std::vector<u32>> dirSetData;
+
+        if (!spansSeparator)
+        {
+            std::vector<u32> hits;
+            for (u32 entry = 0; entry < count; ++entry)
+            {
+                if (!index.IsDirectory(entry))
+                    continue;
+
+                hits.clear();
+                u32 parent = index.parents[entry];
+                if (parent != InvalidEntry && dirSets[parent] != UINT32_MAX)
+                    hits = dirSetData[dirSets[parent]];
+
+                matcher.Scan(index.GetName(entry), [&](u32 pattern) {
+                    InsertPattern(hits, pattern);
+                });
+
+                if (!hits.empty())
+                {
+                    dirSets[entry] = u32(dirSetData.size());
+                    dirSetData.push_back(hits);
+                }
+            }
+        }
+
+        // Pass 2: Scan every entry's name in parallel, combine with the parent
+        // directory's hits and test the queries keyed by each hit pattern
+
+        constexpr u64 Grain = 64 * 1024;
+        u64 chunkCount = (count + Grain - 1) / Grain;
+        std::vector<std::vector<std::pair<u32, u32>>> chunkMatches(chunkCount);
+
+        struct Scratch
+        {
+            std::vector<u32> hits;
+            std::string path;
+        };
+        std::vector<Scratch> scratch(GetWorkerCount());
+
+        ParallelFor(count, Grain, [&](u64 begin, u64 end, u32 worker) {
+            auto& hits = scratch[worker].hits;
+            auto& path = scratch[worker].path;
+            auto& matches = chunkMatches[begin / Grain];
+
+            for (u32 entry = u32(begin); entry < end; ++entry)
+            {
+                hits.clear();
+                if (spansSeparator)
+                {
+                    index.GetFullPath(entry, path);
+                    matcher.Scan(path, [&](u32 pattern) { InsertPattern(hits, pattern); });
+                }
+                else
+                {
+                    u32 parent = index.parents[entry];
+                    if (parent != InvalidEntry && dirSets[parent] != UINT32_MAX)
+                        hits = dirSetData[dirSets[parent]];
+                    matcher.Scan(index.GetName(entry), [&](u32 pattern) { InsertPattern(hits, pattern); });
+                }
+
+                for (u32 pattern : hits)
+                {
+                    for (u32 q : queriesByPattern[pattern])
+                    {
+                        bool all = true;
+                        for (u32 required : queryPatterns[q])
+                        {
+                            if (!ContainsPattern(hits, required))
+                            {
+                                all = false;
+                                break;
+                            }
+                        }
+
+                        for (auto& pattern : fuzzy[q])
+                            all = all && pattern.Matches(index.GetName(entry));
+
+                        if (all && filters[q].Matches(index, entry))
+                            matches.emplace_back(q, entry);
+                    }
+                }
+            }
+        });
+
+        // Chunks are in index order, so concatenating keeps per query order
+
+        for (auto& matches : chunkMatches)
+        {
+            for (auto [q, entry] : matches)
+            {
+                if (results[q].size() < limit)
+                    results[q].push_back(entry);
+            }
+        }
+    }
+}
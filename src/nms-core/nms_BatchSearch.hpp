@@ -0,0 +1,19 @@
+#pragma once
+
+#include "nms_Index.hpp"
+
+namespace nms
+{
+    // Evaluates many queries against an index in a single pass. Each query
+    // is a list of keywords with the same semantics as Searcher::Filter. All
+    // keywords are compiled into one Aho-Corasick automaton, entry names are
+    // scanned once and the per-directory hits are inherited by descendants.
+    //
+    // results[q] receives the matching entries of queries[q] in index order,
+    // up to limit per query. Queries without name keywords produce no results.
+    void BatchSearch(
+        const Index& index,
+        nova::Span<std::vector<std::string>> queries,
+        std::vector<std::vector<u32>>& results,
+        u32 limit = UINT32_MAX);
+}
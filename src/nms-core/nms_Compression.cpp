@@ -0,0 +1,215 @@
+#include "nms_Compression.hpp"
+
+namespace nms
+{
+    namespace
+    {
+        constexpr usz MinMatch = 4;
+        constexpr usz MaxOffset = 65535;
+
+        // Matches never cover the last bytes of a block and never start in
+        // the last MatchSearchLimit bytes, leaving room for wide loads
+        constexpr usz LastLiterals = 5;
+        constexpr usz MatchSearchLimit = 12;
+
+        constexpr u32 HashBits = 14;
+
+        constexpr usz WideCopy = 16;
+
+        u32 Load32(const u8* p)
+        {
+            u32 value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        u64 Load64(const u8* p)
+        {
+            u64 value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        u32 Hash(u32 sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - HashBits);
+        }
+
+        // Length of the common run at ip and from, stopping at limit
+        usz CountMatch(const u8* ip, const u8* from, const u8* limit)
+        {
+            const u8* start = ip;
+            while (ip + sizeof(u64) <= limit)
+            {
+                u64 diff = Load64(ip) ^ Load64(from);
+                if (diff)
+                    return usz(ip - start) + std::countr_zero(diff) / 8; // Little endian
+
+                ip += sizeof(u64);
+                from += sizeof(u64);
+            }
+
+            while (ip < limit && *ip == *from)
+            {
+                ip++;
+                from++;
+            }
+            return usz(ip - start);
+        }
+
+        void WriteLength(u8*& out, usz length)
+        {
+            while (length >= 255)
+            {
+                *out++ = 255;
+                length -= 255;
+            }
+            *out++ = u8(length);
+        }
+
+        void WriteSequence(u8*& out, const u8* literals, usz literalLength, usz offset, usz matchLength)
+        {
+            u8* token = out++;
+            *token = u8(std::min<usz>(literalLength, 15) << 4);
+            if (literalLength >= 15)
+                WriteLength(out, literalLength - 15);
+
+            std::memcpy(out, literals, literalLength);
+            out += literalLength;
+
+            // The final sequence carries literals only
+            if (!matchLength)
+                return;
+
+            *out++ = u8(offset);
+            *out++ = u8(offset >> 8);
+
+            usz length = matchLength - MinMatch;
+            *token |= u8(std::min<usz>(length, 15));
+            if (length >= 15)
+                WriteLength(out, length - 15);
+        }
+    }
+
+    usz CompressBlock(nova::Span<u8> input, u8* output)
+    {
+        const u8* src = input.data();
+        const u8* end = src + input.size();
+        const u8* anchor = src;
+        u8* out = output;
+
+        if (input.size() > MatchSearchLimit)
+        {
+            // Stale slots only cost a failed comparison
+            std::vector<u32> table(1 << HashBits);
+
+            const u8* searchEnd = end - MatchSearchLimit;
+            const u8* matchLimit = end - LastLiterals;
+            const u8* ip = src;
+            while (ip < searchEnd)
+            {
+                u32 sequence = Load32(ip);
+                u32& slot = table[Hash(sequence)];
+                const u8* candidate = src + slot;
+                slot = u32(ip - src);
+
+                if (candidate >= ip || usz(ip - candidate) > MaxOffset || Load32(candidate) != sequence)
+                {
+                    // Step faster through data that does not compress
+                    ip += 1 + (usz(ip - anchor) >> 6);
+                    continue;
+                }
+
+                while (ip > anchor && candidate > src && ip[-1] == candidate[-1])
+                {
+                    ip--;
+                    candidate--;
+                }
+
+                const u8* matchEnd = ip + MinMatch;
+                matchEnd += CountMatch(matchEnd, candidate + MinMatch, matchLimit);
+
+                WriteSequence(out, anchor, usz(ip - anchor), usz(ip - candidate), usz(matchEnd - ip));
+                ip = anchor = matchEnd;
+            }
+        }
+
+        WriteSequence(out, anchor, usz(end - anchor), 0, 0);
+        return usz(out - output);
+    }
+
+    bool DecompressBlock(nova::Span<u8> input, u8* output, usz outputSize)
+    {
+        const u8* ip = input.data();
+        const u8* ipEnd = ip + input.size();
+        u8* op = output;
+        u8* opEnd = output + outputSize;
+
+        auto readLength = [&](usz& length) {
+            u8 byte;
+            do
+            {
+                if (ip >= ipEnd)
+                    return false;
+                byte = *ip++;
+                length += byte;
+            }
+            while (byte == 255);
+            return true;
+        };
+
+        while (ip < ipEnd)
+        {
+            u8 token = *ip++;
+
+            usz literalLength = token >> 4;
+            if (literalLength == 15 && !readLength(literalLength))
+                return false;
+            if (literalLength > usz(ipEnd - ip) || literalLength > usz(opEnd - op))
+                return false;
+
+            // Far from both ends, short runs are copied with fixed size
+            // copies that may write past the run, later output overwrites it
+            if (literalLength <= WideCopy && ipEnd - ip >= i64(WideCopy) && opEnd - op >= i64(WideCopy))
+                std::memcpy(op, ip, WideCopy);
+            else
+                std::memcpy(op, ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+
+            if (ip == ipEnd)
+                break;
+
+            if (ipEnd - ip < 2)
+                return false;
+            usz offset = usz(ip[0]) | usz(ip[1]) << 8;
+            ip += 2;
+
+            usz matchLength = (token & 15) + MinMatch;
+            if ((token & 15) == 15 && !readLength(matchLength))
+                return false;
+            if (!offset || offset > usz(op - output) || matchLength > usz(opEnd - op))
+                return false;
+
+            const u8* match = op - offset;
+            if (offset >= WideCopy && usz(opEnd - op) >= matchLength + WideCopy)
+            {
+                for (usz i = 0; i < matchLength; i += WideCopy)
+                    std::memcpy(op + i, match + i, WideCopy);
+            }
+            else if (offset >= matchLength)
+            {
+                std::memcpy(op, match, matchLength);
+            }
+            else
+            {
+                // Overlapping matches repeat the last offset bytes
+                for (usz i = 0; i < matchLength; ++i)
+                    op[i] = match[i];
+            }
+            op += matchLength;
+        }
+
+        return op == opEnd;
+    }
+}
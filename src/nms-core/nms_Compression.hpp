@@ -0,0 +1,26 @@
+#pragma once
+
+#include <nova/core/nova_Core.hpp>
+
+using namespace nova::types;
+
+namespace nms
+{
+    // Byte oriented LZ77 in the LZ4 block layout: each sequence is a token
+    // of literal and match length nibbles, extended lengths, the literals
+    // and a 16 bit match offset. Greedy matching through a single hash table
+    // keeps compression fast, decoding is little more than copies.
+
+    // Worst case output size for size input bytes
+    constexpr usz GetMaxCompressedSize(usz size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    // Returns the number of bytes written to output, which must hold at
+    // least GetMaxCompressedSize(input.size()) bytes
+    usz CompressBlock(nova::Span<u8> input, u8* output);
+
+    // Decodes exactly outputSize bytes, false if the input is corrupt
+    bool DecompressBlock(nova::Span<u8> input, u8* output, usz outputSize);
+}
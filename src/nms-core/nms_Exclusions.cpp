@@ -0,0 +1,257 @@
+#include "nms_Exclusions.hpp"
+
+#include "nms_Paths.hpp"
+
+#include <nova/core/nova_Debug.hpp>
+
+namespace nms
+{
+    u64 ExclusionRules::FoldedHash::operator()(std::string_view value) const
+    {
+        // FNV-1a over folded bytes, so lookups never need a folded copy
+
+        u64 hash = 14695981039346656037ull;
+        for (c8 c : value)
+        {
+            hash ^= u8(FoldChar(c));
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool ExclusionRules::FoldedEqual::operator()(std::string_view lhs, std::string_view rhs) const
+    {
+        return CompareFolded(lhs, rhs) == 0;
+    }
+
+    ExclusionRules::ExclusionRules()
+    {
+        attributes.fill(InvalidRule);
+    }
+
+    static bool HasWildcards(std::string_view pattern)
+    {
+        return pattern.find_first_of("*?") != std::string_view::npos;
+    }
+
+    void ExclusionRules::Add(std::string_view line)
+    {
+        while (!line.empty() && std::isspace(u8(line.back())))
+            line.remove_suffix(1);
+        while (!line.empty() && std::isspace(u8(line.front())))
+            line.remove_prefix(1);
+
+        if (line.empty() || line.starts_with('#'))
+            return;
+
+        u32 id = u32(rules.size());
+        auto& rule = rules.emplace_back();
+        rule.pattern = line;
+
+        if (line.starts_with('!'))
+        {
+            rule.negated = true;
+            line.remove_prefix(1);
+        }
+
+        if (line.starts_with("attr:"))
+        {
+            auto name = line.substr(5);
+            u8 attribute = 0;
+            if      (name == "hidden")   attribute = EntryAttributes::Hidden;
+            else if (name == "system")   attribute = EntryAttributes::System;
+            else if (name == "readonly") attribute = EntryAttributes::ReadOnly;
+            else if (name == "symlink")  attribute = EntryAttributes::Symlink;
+            else
+            {
+                NOVA_LOG("Unknown attribute in exclusion rule: {}", rule.pattern);
+                rules.pop_back();
+                return;
+            }
+
+            attributes[std::countr_zero(attribute)] = id;
+            return;
+        }
+
+        if (line.size() > 1 && (line.back() == '/' || line.back() == '\\'))
+        {
+            rule.directoryOnly = true;
+            line.remove_suffix(1);
+        }
+
+        rule.glob.reserve(line.size());
+        for (c8 c : line)
+            rule.glob.push_back(c == '\\' ? '/' : FoldChar(c));
+
+        std::string_view glob = rule.glob;
+        if (glob.find('/') != std::string_view::npos)
+        {
+            // Anchored to the shard root, a leading separator only marks that
+            if (glob.starts_with('/'))
+                rule.glob.erase(0, 1);
+            pathGlobs.push_back(id);
+        }
+        else if (!HasWildcards(glob))
+        {
+            names[rule.glob].push_back(id);
+        }
+        else if (glob.starts_with("*.") && !HasWildcards(glob.substr(1)) && glob.substr(2).find('.') == std::string_view::npos)
+        {
+            extensions[std::string(glob.substr(1))].push_back(id);
+        }
+        else
+        {
+            nameGlobs.push_back(id);
+        }
+    }
+
+    bool ExclusionRules::NeedsAttributes() const
+    {
+        return std::ranges::any_of(attributes, [](u32 rule) { return rule != InvalidRule; });
+    }
+
+    // Globs are folded at compile time. In path mode * and ? do not cross
+    // separators, ** does and **/ also matches no directories at all.
+    static bool MatchGlob(std::string_view pattern, std::string_view text, bool path)
+    {
+        while (!pattern.empty())
+        {
+            if (path && pattern.starts_with("**"))
+            {
+                pattern.remove_prefix(2);
+                if (pattern.starts_with('/'))
+                {
+                    pattern.remove_prefix(1);
+                    for (usz i = 0;;)
+                    {
+                        if (MatchGlob(pattern, text.substr(i), path))
+                            return true;
+                        i = text.find('/', i);
+                        if (i == std::string_view::npos)
+                            return false;
+                        i++;
+                    }
+                }
+
+                for (usz i = 0; i <= text.size(); ++i)
+                {
+                    if (MatchGlob(pattern, text.substr(i), path))
+                        return true;
+                }
+                return false;
+            }
+
+            if (pattern[0] == '*')
+            {
+                pattern.remove_prefix(1);
+                for (usz i = 0; i <= text.size(); ++i)
+                {
+                    if (MatchGlob(pattern, text.substr(i), path))
+                        return true;
+                    if (path && i < text.size() && text[i] == '/')
+                        return false;
+                }
+                return false;
+            }
+
+            if (text.empty())
+                return false;
+
+            if (pattern[0] == '?')
+            {
+                if (path && text[0] == '/')
+                    return false;
+            }
+            else if (pattern[0] != FoldChar(text[0]))
+            {
+                return false;
+            }
+
+            pattern.remove_prefix(1);
+            text.remove_prefix(1);
+        }
+
+        return text.empty();
+    }
+
+    bool ExclusionRules::Applies(u32 rule, bool isDirectory) const
+    {
+        return isDirectory || !rules[rule].directoryOnly;
+    }
+
+    void ExclusionRules::Consider(u32& best, const std::vector<u32>& candidates, bool isDirectory) const
+    {
+        for (u32 rule : candidates)
+        {
+            if ((best == InvalidRule || rule > best) && Applies(rule, isDirectory))
+                best = rule;
+        }
+    }
+
+    u32 ExclusionRules::Match(std::string_view name, std::string_view relativePath, bool isDirectory, u8 entryAttributes) const
+    {
+        u32 best = InvalidRule;
+
+        if (auto iter = names.find(name); iter != names.end())
+            Consider(best, iter->second, isDirectory);
+
+        if (auto dot = name.rfind('.'); dot != std::string_view::npos)
+        {
+            if (auto iter = extensions.find(name.substr(dot)); iter != extensions.end())
+                Consider(best, iter->second, isDirectory);
+        }
+
+        // Later rules take precedence, so each list is walked from the back
+        // and stops as soon as it can no longer beat the current best
+
+        for (auto iter = nameGlobs.rbegin(); iter != nameGlobs.rend(); ++iter)
+        {
+            u32 rule = *iter;
+            if (best != InvalidRule && rule < best)
+                break;
+            if (Applies(rule, isDirectory) && MatchGlob(rules[rule].glob, name, false))
+            {
+                best = rule;
+                break;
+            }
+        }
+
+        for (auto iter = pathGlobs.rbegin(); iter != pathGlobs.rend(); ++iter)
+        {
+            u32 rule = *iter;
+            if (best != InvalidRule && rule < best)
+                break;
+            if (Applies(rule, isDirectory) && MatchGlob(rules[rule].glob, relativePath, true))
+            {
+                best = rule;
+                break;
+            }
+        }
+
+        for (u32 bit = 0; entryAttributes >> bit; ++bit)
+        {
+            u32 rule = attributes[bit];
+            if ((entryAttributes & (1 << bit)) && rule != InvalidRule && (best == InvalidRule || rule > best))
+                best = rule;
+        }
+
+        if (best != InvalidRule && rules[best].negated)
+            return InvalidRule;
+
+        return best;
+    }
+
+// -----------------------------------------------------------------------------
+
+    ExclusionRules LoadExclusionRules()
+    {
+        ExclusionRules rules;
+
+        std::ifstream in(GetDataDir() / "exclude.txt");
+        std::string line;
+        while (std::getline(in, line))
+            rules.Add(line);
+
+        return rules;
+    }
+}
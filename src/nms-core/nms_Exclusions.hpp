@@ -0,0 +1,93 @@
+#pragma once
+
+#include "nms_Index.hpp"
+
+namespace nms
+{
+    // Ignore rules compiled for matching during the crawl. Rules follow
+    // gitignore syntax, matched case-insensitively:
+    //
+    //   node_modules/        directories named node_modules, anywhere
+    //   *.pdb                any name matching the glob, anywhere
+    //   /build/              build at the root of the shard only
+    //   **/.git/objects/     any path ending in .git/objects
+    //   !keep.pdb            re-include a name excluded by an earlier rule
+    //   attr:hidden          entries with an attribute (hidden, system, readonly, symlink)
+    //
+    // Patterns containing a separator match the path relative to the shard
+    // root using '/', where * and ? stop at separators and ** does not. The
+    // last matching rule wins. Excluded directories are never opened, so
+    // nothing below them can be re-included.
+    //
+    // Plain names and *.ext rules are looked up in hash tables, only the
+    // remaining globs are tested one by one.
+
+    class ExclusionRules
+    {
+        struct FoldedHash
+        {
+            using is_transparent = void;
+            u64 operator()(std::string_view value) const;
+        };
+
+        struct FoldedEqual
+        {
+            using is_transparent = void;
+            bool operator()(std::string_view lhs, std::string_view rhs) const;
+        };
+
+        using RuleTable = ankerl::unordered_dense::map<std::string, std::vector<u32>, FoldedHash, FoldedEqual>;
+
+        struct Rule
+        {
+            std::string pattern;
+            std::string glob;
+            bool negated = false;
+            bool directoryOnly = false;
+        };
+
+        std::vector<Rule> rules;
+
+        RuleTable names;
+        RuleTable extensions;
+        std::vector<u32> nameGlobs;
+        std::vector<u32> pathGlobs;
+        std::array<u32, 8> attributes;
+
+    public:
+        ExclusionRules();
+
+        // Adds one line of rule syntax, ignoring blank lines and # comments
+        void Add(std::string_view line);
+
+        u32 Size() const
+        {
+            return u32(rules.size());
+        }
+
+        std::string_view GetPattern(u32 rule) const
+        {
+            return rules[rule].pattern;
+        }
+
+        bool NeedsPath() const
+        {
+            return !pathGlobs.empty();
+        }
+
+        bool NeedsAttributes() const;
+
+        // Returns the rule that excludes the entry, or InvalidRule if the
+        // entry is kept. relativePath is only used when NeedsPath is set.
+        u32 Match(std::string_view name, std::string_view relativePath, bool isDirectory, u8 entryAttributes) const;
+
+        static constexpr u32 InvalidRule = UINT32_MAX;
+
+    private:
+        bool Applies(u32 rule, bool isDirectory) const;
+        void Consider(u32& best, const std::vector<u32>& candidates, bool isDirectory) const;
+    };
+
+    // Reads <data dir>/exclude.txt, no rules if it does not exist
+    ExclusionRules LoadExclusionRules();
+}
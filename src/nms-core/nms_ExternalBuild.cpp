@@ -0,0 +1,509 @@
+#include "nms_ExternalBuild.hpp"
+
+#include "nms_Memory.hpp"
+#include "nms_Parallel.hpp"
+#include "nms_Acronyms.hpp"
+
+#include <nova/core/nova_Guards.hpp>
+
+namespace nms
+{
+    namespace
+    {
+        constexpr usz StreamBufferSize = 1024 * 1024;
+
+        struct BufferedWriter
+        {
+            std::vector<c8> buffer;
+            std::ofstream out;
+
+            BufferedWriter(const std::filesystem::path& path, usz bufferSize = StreamBufferSize)
+                : buffer(bufferSize)
+            {
+                out.rdbuf()->pubsetbuf(buffer.data(), std::streamsize(buffer.size()));
+                out.open(path, std::ios::binary | std::ios::trunc);
+                if (!out)
+                    throw std::runtime_error(NOVA_FORMAT("Failed to create build file: {}", PathToUtf8(path)));
+            }
+
+            template<class T>
+            void Write(const T& value)
+            {
+                out.write(reinterpret_cast<const c8*>(&value), sizeof(T));
+            }
+
+            void WriteBytes(std::string_view bytes)
+            {
+                out.write(bytes.data(), std::streamsize(bytes.size()));
+            }
+        };
+
+        struct Record
+        {
+            u64 prefix;
+            u32 crawlId;
+            u32 parent;
+            u16 depth;
+            u8 flags;
+            EntryMetadata metadata;
+            std::string name;
+        };
+
+        bool RecordLess(const Record& l, const Record& r)
+        {
+            if (l.prefix != r.prefix)
+                return l.prefix < r.prefix;
+
+            if (i32 cmp = CompareFolded(l.name, r.name))
+                return cmp < 0;
+
+            return l.crawlId < r.crawlId;
+        }
+
+        // Run files hold records sorted by the index sort key:
+        //   u32 crawlId, u32 parent, u16 depth, u8 flags,
+        //   u64 size, u32 modified, u8 attributes, u16 nameLength, name
+
+        struct RunReader
+        {
+            std::vector<c8> buffer;
+            std::ifstream in;
+            Record current;
+
+            RunReader(const std::filesystem::path& path, usz bufferSize)
+                : buffer(bufferSize)
+            {
+                in.rdbuf()->pubsetbuf(buffer.data(), std::streamsize(buffer.size()));
+                in.open(path, std::ios::binary);
+                if (!in)
+                    throw std::runtime_error(NOVA_FORMAT("Failed to open run file: {}", PathToUtf8(path)));
+            }
+
+            bool Next()
+            {
+                u16 nameLength;
+                in.read(reinterpret_cast<c8*>(&current.crawlId), sizeof(current.crawlId));
+                in.read(reinterpret_cast<c8*>(&current.parent), sizeof(current.parent));
+                in.read(reinterpret_cast<c8*>(&current.depth), sizeof(current.depth));
+                in.read(reinterpret_cast<c8*>(&current.flags), sizeof(current.flags));
+                in.read(reinterpret_cast<c8*>(&current.metadata.size), sizeof(current.metadata.size));
+                in.read(reinterpret_cast<c8*>(&current.metadata.modified), sizeof(current.metadata.modified));
+                in.read(reinterpret_cast<c8*>(&current.metadata.attributes), sizeof(current.metadata.attributes));
+                in.read(reinterpret_cast<c8*>(&nameLength), sizeof(nameLength));
+                if (!in)
+                    return false;
+
+                current.name.resize(nameLength);
+                in.read(current.name.data(), nameLength);
+                current.prefix = MakeSortPrefix(current.depth, current.name);
+                return bool(in);
+            }
+        };
+
+        struct RunEntry
+        {
+            u64 prefix;
+            u32 crawlId;
+            u32 parent;
+            u32 nameOffset;
+            u16 nameLength;
+            u16 depth;
+            u8 flags;
+            EntryMetadata metadata;
+        };
+
+        class RunBuffer
+        {
+            std::vector<RunEntry> entries;
+            std::string names;
+            usz capacity;
+
+        public:
+            // Sorting needs scratch space equal to the entries, so entries are
+            // counted twice. Both buffers are reserved up front and never grow.
+            explicit RunBuffer(u64 budget)
+            {
+                constexpr usz AverageName = 24;
+                capacity = std::max<usz>(1024, budget / (2 * sizeof(RunEntry) + AverageName));
+                entries.reserve(capacity);
+                names.reserve(capacity * AverageName);
+            }
+
+            bool IsFull(usz nameLength) const
+            {
+                return entries.size() == capacity || names.size() + nameLength > names.capacity();
+            }
+
+            bool IsEmpty() const
+            {
+                return entries.empty();
+            }
+
+            void Add(u32 crawlId, u32 parent, u16 depth, std::string_view name, u8 flags, const EntryMetadata& metadata)
+            {
+                entries.push_back({
+                    .prefix = MakeSortPrefix(depth, name),
+                    .crawlId = crawlId,
+                    .parent = parent,
+                    .nameOffset = u32(names.size()),
+                    .nameLength = u16(name.size()),
+                    .depth = depth,
+                    .flags = flags,
+                    .metadata = metadata,
+                });
+                names.append(name);
+            }
+
+            void Spill(const std::filesystem::path& path)
+            {
+                auto name = [&](const RunEntry& e) {
+                    return std::string_view(names).substr(e.nameOffset, e.nameLength);
+                };
+
+                ParallelSort(entries, [&](const RunEntry& l, const RunEntry& r) {
+                    if (l.prefix != r.prefix)
+                        return l.prefix < r.prefix;
+
+                    if (i32 cmp = CompareFolded(name(l), name(r)))
+                        return cmp < 0;
+
+                    return l.crawlId < r.crawlId;
+                });
+
+                BufferedWriter writer(path);
+                for (auto& entry : entries)
+                {
+                    writer.Write(entry.crawlId);
+                    writer.Write(entry.parent);
+                    writer.Write(entry.depth);
+                    writer.Write(entry.flags);
+                    writer.Write(entry.metadata.size);
+                    writer.Write(entry.metadata.modified);
+                    writer.Write(entry.metadata.attributes);
+                    writer.Write(entry.nameLength);
+                    writer.WriteBytes(name(entry));
+                }
+
+                if (!writer.out)
+                    throw std::runtime_error(NOVA_FORMAT("Failed to write run file: {}", PathToUtf8(path)));
+
+                entries.clear();
+                names.clear();
+            }
+        };
+
+        // K-way merge of run files, visiting every record in sort key order
+        template<class Visit>
+        void MergeRuns(const std::vector<std::filesystem::path>& paths, usz bufferSize, Visit&& visit)
+        {
+            std::vector<std::unique_ptr<RunReader>> readers;
+            for (auto& path : paths)
+            {
+                auto& reader = readers.emplace_back(std::make_unique<RunReader>(path, bufferSize));
+                if (!reader->Next())
+                    readers.pop_back();
+            }
+
+            auto greater = [&](u32 l, u32 r) { return RecordLess(readers[r]->current, readers[l]->current); };
+            std::priority_queue<u32, std::vector<u32>, decltype(greater)> heap(greater);
+            for (u32 i = 0; i < readers.size(); ++i)
+                heap.push(i);
+
+            while (!heap.empty())
+            {
+                u32 top = heap.top();
+                heap.pop();
+
+                visit(readers[top]->current);
+
+                if (readers[top]->Next())
+                    heap.push(top);
+            }
+        }
+
+        // Fills table with the value of each (key, value) pair in the file
+        // whose key falls in [low, high)
+        void LoadPairs(const std::filesystem::path& path, u64 low, u64 high, std::vector<u32>& table)
+        {
+            table.assign(high - low, InvalidEntry);
+
+            std::ifstream in(path, std::ios::binary);
+            std::vector<u32> pairChunk(2 * 128 * 1024);
+            while (in)
+            {
+                in.read(reinterpret_cast<c8*>(pairChunk.data()), std::streamsize(pairChunk.size() * sizeof(u32)));
+                usz count = usz(in.gcount()) / sizeof(u32);
+                for (usz i = 0; i + 1 < count; i += 2)
+                {
+                    if (pairChunk[i] >= low && pairChunk[i] < high)
+                        table[pairChunk[i] - low] = pairChunk[i + 1];
+                }
+            }
+        }
+
+        void AppendFile(IndexFileWriter& out, const std::filesystem::path& path, std::vector<c8>& buffer)
+        {
+            std::ifstream in(path, std::ios::binary);
+            while (in)
+            {
+                in.read(buffer.data(), std::streamsize(buffer.size()));
+                out.Write(buffer.data(), usz(in.gcount()));
+            }
+        }
+    }
+
+    void BuildIndexExternal(
+        const std::filesystem::path& root,
+        const std::filesystem::path& file,
+        const std::filesystem::path& tempDir,
+        u64 memoryBudget,
+        const ExclusionRules* exclusions,
+        ExternalBuildStats* stats,
+        IndexEncoding encoding)
+    {
+        std::filesystem::create_directories(tempDir);
+        NOVA_DEFER(&) {
+            std::error_code ec;
+            std::filesystem::remove_all(tempDir, ec);
+        };
+
+        // Half of the budget buffers runs, the rest covers the crawler,
+        // stream buffers and the merge
+
+        auto runPath = [&](u32 run) { return tempDir / NOVA_FORMAT("run-{}.bin", run); };
+        auto nameRunPath = [&](u32 run) { return tempDir / NOVA_FORMAT("names-{}.bin", run); };
+
+        u32 runCount = 0;
+        u32 crawlCount = 0;
+        u32 scanTime = GetUnixTime();
+        {
+            RunBuffer buffer(memoryBudget / 2);
+
+            CrawlFilesystem(root, [&](u32 parent, u16 depth, std::string_view name, u8 entryFlags, const EntryMetadata& metadata) {
+                if (buffer.IsFull(name.size()))
+                    buffer.Spill(runPath(runCount++));
+
+                buffer.Add(crawlCount, parent, depth, name, entryFlags, metadata);
+                return crawlCount++;
+            }, exclusions, stats ? &stats->pruned : nullptr);
+
+            if (!buffer.IsEmpty())
+                buffer.Spill(runPath(runCount++));
+        }
+
+        // K-way merge of all runs into separate column files. Parents are
+        // still crawl ids at this point, the (crawl id, final id) pairs are
+        // recorded to remap them afterwards.
+        //
+        // Final ids and names are spilled again at depth 0 as the merge goes,
+        // so their own runs sort by folded name and merge into the name order.
+
+        u32 nameRunCount = 0;
+        {
+            std::vector<std::filesystem::path> runs;
+            for (u32 run = 0; run < runCount; ++run)
+                runs.push_back(runPath(run));
+
+            usz readBuffer = std::max<usz>(64 * 1024, memoryBudget / 4 / std::max(runCount, 1u));
+            RunBuffer nameBuffer(memoryBudget / 4);
+
+            BufferedWriter parents(tempDir / "parents.bin");
+            BufferedWriter depths(tempDir / "depths.bin");
+            BufferedWriter flags(tempDir / "flags.bin");
+            BufferedWriter sizes(tempDir / "sizes.bin");
+            BufferedWriter modifiedTimes(tempDir / "modified.bin");
+            BufferedWriter attributes(tempDir / "attributes.bin");
+            BufferedWriter wordStarts(tempDir / "wordstarts.bin");
+            BufferedWriter acronyms(tempDir / "acronyms.bin");
+            BufferedWriter pairs(tempDir / "pairs.bin");
+
+            u32 finalId = 0;
+            MergeRuns(runs, readBuffer, [&](const Record& record) {
+                parents.Write(record.parent);
+                depths.Write(record.depth);
+                flags.Write(record.flags);
+                sizes.Write(record.metadata.size);
+                modifiedTimes.Write(record.metadata.modified);
+                attributes.Write(record.metadata.attributes);
+                wordStarts.Write(GetWordStarts(record.name));
+                acronyms.Write(PackAcronym(record.name));
+                pairs.Write(record.crawlId);
+                pairs.Write(finalId);
+
+                if (nameBuffer.IsFull(record.name.size()))
+                    nameBuffer.Spill(nameRunPath(nameRunCount++));
+                nameBuffer.Add(finalId, 0, 0, record.name, 0, {});
+
+                finalId++;
+            });
+
+            if (!nameBuffer.IsEmpty())
+                nameBuffer.Spill(nameRunPath(nameRunCount++));
+
+            for (auto* writer : { &parents, &depths, &flags, &sizes, &modifiedTimes, &attributes, &wordStarts, &acronyms, &pairs })
+            {
+                writer->out.close();
+                if (!writer->out)
+                    throw std::runtime_error("Failed to write index columns");
+            }
+        }
+
+        for (u32 run = 0; run < runCount; ++run)
+            std::filesystem::remove(runPath(run));
+
+        // Merge the name runs into the name order, interning names as they
+        // come. Equal names are adjacent apart from names that differ only
+        // in case, so only the distinct names of the current folded run are
+        // kept. Each entry's (final id, name id) pair is recorded to place
+        // the name ids afterwards.
+
+        u64 namesSize = 0;
+        u32 nameCount = 0;
+        {
+            std::vector<std::filesystem::path> runs;
+            for (u32 run = 0; run < nameRunCount; ++run)
+                runs.push_back(nameRunPath(run));
+
+            usz readBuffer = std::max<usz>(64 * 1024, memoryBudget / 4 / std::max(nameRunCount, 1u));
+            BufferedWriter offsets(tempDir / "offsets.bin");
+            BufferedWriter names(tempDir / "names.bin");
+            BufferedWriter nameOrder(tempDir / "nameorder.bin");
+            BufferedWriter namePairs(tempDir / "namepairs.bin");
+
+            offsets.Write(u32(0));
+
+            std::vector<std::pair<std::string, u32>> distinct;
+            MergeRuns(runs, readBuffer, [&](const Record& record) {
+                if (!distinct.empty() && CompareFolded(distinct[0].first, record.name) != 0)
+                    distinct.clear();
+
+                u32 id = InvalidEntry;
+                for (auto& [name, existing] : distinct)
+                {
+                    if (name == record.name)
+                    {
+                        id = existing;
+                        break;
+                    }
+                }
+
+                if (id == InvalidEntry)
+                {
+                    namesSize += record.name.size();
+                    if (namesSize > UINT32_MAX)
+                        throw std::runtime_error("Index name data exceeds 4 GiB");
+
+                    id = nameCount++;
+                    offsets.Write(u32(namesSize));
+                    names.WriteBytes(record.name);
+                    distinct.emplace_back(record.name, id);
+                }
+
+                nameOrder.Write(record.crawlId);
+                namePairs.Write(record.crawlId);
+                namePairs.Write(id);
+            });
+
+            for (auto* writer : { &offsets, &names, &nameOrder, &namePairs })
+            {
+                writer->out.close();
+                if (!writer->out)
+                    throw std::runtime_error("Failed to write name columns");
+            }
+
+            for (auto& run : runs)
+                std::filesystem::remove(run);
+        }
+
+        // Remap parent crawl ids to final ids. Each pass loads the part of
+        // the mapping that fits in the budget and patches the matching parents.
+        // Crawl ids are read from the original column and remapped ids are
+        // written to a copy, so a remapped id is never mistaken for a crawl id.
+
+        u32 fixupPasses = 0;
+        {
+            u64 passSize = std::max<u64>(1024 * 1024, memoryBudget / 2 / sizeof(u32));
+            std::vector<u32> table;
+            std::vector<u32> crawlChunk(128 * 1024);
+            std::vector<u32> finalChunk(128 * 1024);
+
+            std::filesystem::copy_file(tempDir / "parents.bin", tempDir / "remapped.bin");
+            std::ifstream crawlColumn(tempDir / "parents.bin", std::ios::binary);
+            std::fstream finalColumn(tempDir / "remapped.bin", std::ios::binary | std::ios::in | std::ios::out);
+
+            for (u64 low = 0; low < crawlCount; low += passSize)
+            {
+                u64 high = std::min<u64>(crawlCount, low + passSize);
+                LoadPairs(tempDir / "pairs.bin", low, high, table);
+                fixupPasses++;
+
+                crawlColumn.clear();
+                crawlColumn.seekg(0);
+                for (u64 offset = 0; offset < crawlCount; offset += crawlChunk.size())
+                {
+                    usz count = usz(std::min<u64>(crawlChunk.size(), crawlCount - offset));
+                    auto bytes = std::streamsize(count * sizeof(u32));
+                    auto position = std::streamoff(offset * sizeof(u32));
+
+                    crawlColumn.read(reinterpret_cast<c8*>(crawlChunk.data()), bytes);
+                    finalColumn.seekg(position);
+                    finalColumn.read(reinterpret_cast<c8*>(finalChunk.data()), bytes);
+
+                    for (usz i = 0; i < count; ++i)
+                    {
+                        if (crawlChunk[i] >= low && crawlChunk[i] < high)
+                            finalChunk[i] = table[crawlChunk[i] - low];
+                    }
+
+                    finalColumn.seekp(position);
+                    finalColumn.write(reinterpret_cast<const c8*>(finalChunk.data()), bytes);
+                }
+
+                if (!crawlColumn || !finalColumn)
+                    throw std::runtime_error("Failed to remap parent column");
+            }
+        }
+
+        // Name ids in final id order, each pass places the ids of as many
+        // entries as fit in the budget
+
+        {
+            u64 passSize = std::max<u64>(1024 * 1024, memoryBudget / 2 / sizeof(u32));
+            std::vector<u32> table;
+            BufferedWriter nameIds(tempDir / "nameids.bin");
+            for (u64 low = 0; low < crawlCount; low += passSize)
+            {
+                u64 high = std::min<u64>(crawlCount, low + passSize);
+                LoadPairs(tempDir / "namepairs.bin", low, high, table);
+                nameIds.out.write(reinterpret_cast<const c8*>(table.data()), std::streamsize(table.size() * sizeof(u32)));
+                fixupPasses++;
+            }
+
+            nameIds.out.close();
+            if (!nameIds.out)
+                throw std::runtime_error("Failed to write name ids");
+        }
+
+        // Assemble the index file from the column files
+
+        {
+            IndexFileWriter out(file, encoding, crawlCount, PathToUtf8(root), nameCount, namesSize, scanTime);
+            std::vector<c8> buffer(1024 * 1024);
+            for (auto column : { "remapped.bin", "offsets.bin", "names.bin", "nameids.bin", "depths.bin", "flags.bin",
+                    "sizes.bin", "modified.bin", "attributes.bin", "wordstarts.bin", "acronyms.bin", "nameorder.bin" })
+                AppendFile(out, tempDir / column, buffer);
+
+            out.Finish();
+        }
+
+        if (stats)
+        {
+            stats->entries = crawlCount;
+            stats->uniqueNames = nameCount;
+            stats->namesBytes = namesSize;
+            stats->runs = runCount;
+            stats->fixupPasses = fixupPasses;
+            stats->peakResidentBytes = GetPeakResidentBytes();
+        }
+    }
+}
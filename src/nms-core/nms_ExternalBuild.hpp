@@ -0,0 +1,37 @@
+#pragma once
+
+#include "nms_Index.hpp"
+
+namespace nms
+{
+    struct ExternalBuildStats
+    {
+        u64 entries = 0;
+        u64 uniqueNames = 0;
+        u64 namesBytes = 0;
+        u32 runs = 0;
+        u32 fixupPasses = 0;
+        u64 peakResidentBytes = 0;
+
+        // Entries skipped by each exclusion rule
+        std::vector<u64> pruned;
+    };
+
+    // Indexes root straight into an index file without holding the index in
+    // memory. Entries are buffered until memoryBudget is reached, then sorted
+    // and spilled to a run file in tempDir. Runs are k-way merged into the
+    // final columns, names are interned while merging a second set of runs
+    // in name order, and parent references and name ids are placed in
+    // passes that each cover as many entries as fit in the budget.
+    //
+    // The output is identical to IndexFilesystem + SortIndex + SaveIndex
+    // with the same encoding.
+    void BuildIndexExternal(
+        const std::filesystem::path& root,
+        const std::filesystem::path& file,
+        const std::filesystem::path& tempDir,
+        u64 memoryBudget,
+        const ExclusionRules* exclusions = nullptr,
+        ExternalBuildStats* stats = nullptr,
+        IndexEncoding encoding = IndexEncoding::Raw);
+}
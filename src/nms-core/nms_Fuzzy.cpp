@@ -0,0 +1,150 @@
+#include "nms_Fuzzy.hpp"
+
+namespace nms
+{
+    FuzzyPattern::FuzzyPattern(std::string_view query)
+    {
+        query = query.substr(0, MaxLength);
+        folded.reserve(query.size());
+        for (usz i = 0; i < query.size(); ++i)
+        {
+            c8 c = FoldChar(query[i]);
+            folded.push_back(c);
+
+            // Folding only maps ASCII lowercase, so each folded byte has at
+            // most one other byte folding onto it
+            masks[u8(c)] |= 1ull << i;
+            if (c >= 'A' && c <= 'Z')
+                masks[u8(c - 'A' + 'a')] |= 1ull << i;
+        }
+
+        if (!folded.empty())
+            accept = 1ull << (folded.size() - 1);
+    }
+
+// -----------------------------------------------------------------------------
+
+    namespace
+    {
+        constexpr i32 ScoreMatch = 16;
+        constexpr i32 ScoreGapStart = -3;
+        constexpr i32 ScoreGapExtension = -1;
+
+        constexpr i32 BonusBoundary = ScoreMatch / 2;
+        constexpr i32 BonusCamel = BonusBoundary - 1;
+        constexpr i32 BonusConsecutive = -(ScoreGapStart + ScoreGapExtension);
+        constexpr i32 BonusFirstCharMultiplier = 2;
+
+        enum class CharClass
+        {
+            NonWord,
+            Lower,
+            Upper,
+            Digit,
+        };
+
+        CharClass Classify(c8 c)
+        {
+            if (c >= 'a' && c <= 'z') return CharClass::Lower;
+            if (c >= 'A' && c <= 'Z') return CharClass::Upper;
+            if (c >= '0' && c <= '9') return CharClass::Digit;
+
+            // Bytes of multi-byte sequences count as word characters
+            if (u8(c) >= 0x80) return CharClass::Lower;
+
+            return CharClass::NonWord;
+        }
+
+        i32 Bonus(CharClass prev, CharClass current)
+        {
+            if (current == CharClass::NonWord)
+                return 0;
+
+            if (prev == CharClass::NonWord)
+                return BonusBoundary;
+
+            if ((prev == CharClass::Lower && current == CharClass::Upper)
+                    || (prev != CharClass::Digit && current == CharClass::Digit))
+                return BonusCamel;
+
+            return 0;
+        }
+    }
+
+    u32 FuzzyPattern::Score(std::string_view text) const
+    {
+        if (folded.empty())
+            return 1;
+
+        // Forward pass finds where the earliest match ends
+
+        usz q = 0;
+        usz end = 0;
+        for (usz i = 0; i < text.size(); ++i)
+        {
+            if (FoldChar(text[i]) == folded[q] && ++q == folded.size())
+            {
+                end = i + 1;
+                break;
+            }
+        }
+
+        if (q != folded.size())
+            return 0;
+
+        // Backward pass from there finds the tightest window ending at it
+
+        usz start = end;
+        q = folded.size();
+        while (q > 0)
+        {
+            start--;
+            if (FoldChar(text[start]) == folded[q - 1])
+                q--;
+        }
+
+        // Score the window
+
+        i32 score = 0;
+        i32 consecutive = 0;
+        i32 firstBonus = 0;
+        bool inGap = false;
+
+        CharClass prev = start > 0 ? Classify(text[start - 1]) : CharClass::NonWord;
+        q = 0;
+        for (usz i = start; i < end; ++i)
+        {
+            CharClass current = Classify(text[i]);
+            if (FoldChar(text[i]) == folded[q])
+            {
+                i32 bonus = Bonus(prev, current);
+                if (consecutive == 0)
+                {
+                    firstBonus = bonus;
+                }
+                else
+                {
+                    // A run keeps the bonus of the boundary it started on
+                    if (bonus == BonusBoundary)
+                        firstBonus = bonus;
+                    bonus = std::max({ bonus, firstBonus, BonusConsecutive });
+                }
+
+                score += ScoreMatch + (q == 0 ? bonus * BonusFirstCharMultiplier : bonus);
+                consecutive++;
+                inGap = false;
+                q++;
+            }
+            else
+            {
+                score += inGap ? ScoreGapExtension : ScoreGapStart;
+                consecutive = 0;
+                firstBonus = 0;
+                inGap = true;
+            }
+            prev = current;
+        }
+
+        return u32(std::max(score, 1));
+    }
+}
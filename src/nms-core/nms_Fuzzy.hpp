@@ -0,0 +1,54 @@
+#pragma once
+
+#include "nms_Index.hpp"
+
+namespace nms
+{
+    // Subsequence matcher for fuzzy keywords ("~vscode" finds "Visual Studio
+    // Code.lnk"). Query characters must appear in order, case insensitively.
+    //
+    // Matches runs a bit-parallel Shift-And automaton, one table lookup and
+    // three bit operations per name byte with no branches on the query, so a
+    // pass over millions of names is bound by name bandwidth.
+    //
+    // Score ranks a match with fzf style bonuses: the tightest window holding
+    // the query is found, then matched characters earn a base score plus
+    // bonuses for word starts, camelCase humps and consecutive runs, while
+    // gaps inside the window cost a penalty.
+
+    class FuzzyPattern
+    {
+        std::string folded;
+        std::array<u64, 256> masks = {};
+        u64 accept = 0;
+
+    public:
+        // Queries longer than 64 characters are truncated
+        static constexpr usz MaxLength = 64;
+
+        explicit FuzzyPattern(std::string_view query);
+
+        bool IsEmpty() const
+        {
+            return folded.empty();
+        }
+
+        bool Matches(std::string_view text) const
+        {
+            if (text.size() < folded.size())
+                return false;
+
+            // States only ever gain bits, so acceptance is tested once at the end
+            u64 state = 0;
+            for (c8 c : text)
+                state |= ((state << 1) | 1) & masks[u8(c)];
+            return state & accept;
+        }
+
+        // Returns 0 if the text does not match
+        u32 Score(std::string_view text) const;
+    };
+
+    // Fuzzy keywords are written with a leading '~'
+    constexpr c8 FuzzyPrefix = '~';
+}
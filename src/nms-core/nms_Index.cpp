@@ -0,0 +1,1193 @@
+#include "nms_Index.hpp"
+#include "nms_Exclusions.hpp"
+#include "nms_Parallel.hpp"
+#include "nms_Compression.hpp"
+#include "nms_Acronyms.hpp"
+
+#include <nova/core/nova_Debug.hpp>
+
+#ifdef _WIN32
+#  include <nova/core/win32/nova_Win32Include.hpp>
+#else
+#  include <sys/stat.h>
+#endif
+
+namespace nms
+{
+    u64 Index::GetMemoryUsage() const
+    {
+        if (arena)
+            return root.capacity() + arena->GetCapacity();
+
+        return root.capacity()
+            + parents.capacity() * sizeof(u32)
+            + nameOffsets.capacity() * sizeof(u32)
+            + names.capacity()
+            + nameIds.capacity() * sizeof(u32)
+            + depths.capacity() * sizeof(u16)
+            + flags.capacity() * sizeof(u8)
+            + sizes.capacity() * sizeof(u64)
+            + modifiedTimes.capacity() * sizeof(u32)
+            + attributes.capacity() * sizeof(u8)
+            + wordStarts.capacity() * sizeof(u32)
+            + acronyms.capacity() * sizeof(u64)
+            + nameOrder.capacity() * sizeof(u32)
+            + preorder.capacity() * sizeof(u32)
+            + postorder.capacity() * sizeof(u32)
+            + dfsOrder.capacity() * sizeof(u32);
+    }
+
+    nova::Span<u32> Index::FindNamed(std::string_view name) const
+    {
+        auto first = std::partition_point(nameOrder.begin(), nameOrder.end(), [&](u32 entry) {
+            return CompareFolded(GetName(entry), name) < 0;
+        });
+        auto last = std::partition_point(first, nameOrder.end(), [&](u32 entry) {
+            return CompareFolded(GetName(entry), name) == 0;
+        });
+        return { nameOrder.data() + (first - nameOrder.begin()), usz(last - first) };
+    }
+
+    nova::Span<u32> Index::FindNamesStartingWith(std::string_view prefix) const
+    {
+        // Names at or after the prefix that start with it form one run
+        auto first = std::partition_point(nameOrder.begin(), nameOrder.end(), [&](u32 entry) {
+            return CompareFolded(GetName(entry), prefix) < 0;
+        });
+        auto last = std::partition_point(first, nameOrder.end(), [&](u32 entry) {
+            return CompareFolded(GetName(entry).substr(0, prefix.size()), prefix) == 0;
+        });
+        return { nameOrder.data() + (first - nameOrder.begin()), usz(last - first) };
+    }
+
+    nova::Span<u32> Index::GetDescendants(u32 entry) const
+    {
+        // Of the entries before a finished subtree in post order, all but
+        // its ancestors came before it in pre order as well
+        u32 first = preorder[entry] + 1;
+        u32 descendants = postorder[entry] - preorder[entry] + depths[entry];
+        return { dfsOrder.data() + first, usz(descendants) };
+    }
+
+    void Index::FindPath(std::string_view path, std::vector<u32>& entries) const
+    {
+        while (path.size() > 1 && path.back() == PathSeparator)
+            path.remove_suffix(1);
+
+        // Only entries with the last name can match
+        auto separator = path.rfind(PathSeparator);
+        auto name = separator == std::string_view::npos ? path : path.substr(separator + 1);
+
+        std::string fullPath;
+        for (u32 entry : FindNamed(name))
+        {
+            GetFullPath(entry, fullPath);
+            if (CompareFolded(fullPath, path) == 0)
+                entries.push_back(entry);
+        }
+    }
+
+    u32 Index::AddEntry(u32 parent, std::string_view name, u8 entryFlags, const EntryMetadata& metadata)
+    {
+        if (names.size() + name.size() > UINT32_MAX)
+            throw std::runtime_error("Index name data exceeds 4 GiB");
+
+        u32 entry = Size();
+        parents.push_back(parent);
+        depths.push_back(parent == InvalidEntry ? u16(0) : u16(depths[parent] + 1));
+        flags.push_back(entryFlags);
+        sizes.push_back(metadata.size);
+        modifiedTimes.push_back(metadata.modified);
+        attributes.push_back(metadata.attributes);
+        wordStarts.push_back(GetWordStarts(name));
+        acronyms.push_back(PackAcronym(name));
+        nameIds.push_back(NameCount());
+        names.append(name);
+        nameOffsets.push_back(u32(names.size()));
+
+        return entry;
+    }
+
+    void Index::GetFullPath(u32 entry, std::string& output) const
+    {
+        // Measure first so the path can be written back to front in place
+
+        usz length = root.size();
+        bool rootSeparator = !root.empty() && root.back() != PathSeparator;
+        for (u32 e = entry; e != InvalidEntry; e = parents[e])
+            length += GetName(e).size() + 1;
+        if (!rootSeparator)
+            length--;
+
+        output.resize(length);
+
+        usz offset = length;
+        for (u32 e = entry; e != InvalidEntry; e = parents[e])
+        {
+            auto name = GetName(e);
+            offset -= name.size();
+            std::memcpy(output.data() + offset, name.data(), name.size());
+            if (offset > 0)
+                output[--offset] = PathSeparator;
+        }
+        std::memcpy(output.data(), root.data(), root.size());
+    }
+
+    std::string Index::GetFullPath(u32 entry) const
+    {
+        std::string path;
+        GetFullPath(entry, path);
+        return path;
+    }
+
+    void Index::Clear()
+    {
+        // Columns are replaced rather than emptied, so arena columns let go
+        // of the arena and the last of them releases it
+        *this = Index();
+    }
+
+// -----------------------------------------------------------------------------
+
+    static constexpr auto FoldTable = [] {
+        std::array<c8, 256> table = {};
+        for (u32 i = 0; i < 256; ++i)
+            table[i] = c8((i >= 'a' && i <= 'z') ? i - 'a' + 'A' : i);
+        return table;
+    }();
+
+    c8 FoldChar(c8 c)
+    {
+        return FoldTable[u8(c)];
+    }
+
+    bool ContainsFolded(std::string_view haystack, std::string_view foldedNeedle)
+    {
+        if (foldedNeedle.empty())
+            return true;
+
+        if (foldedNeedle.size() > haystack.size())
+            return false;
+
+        usz last = haystack.size() - foldedNeedle.size();
+        c8 first = foldedNeedle[0];
+        for (usz i = 0; i <= last; ++i)
+        {
+            if (FoldTable[u8(haystack[i])] != first)
+                continue;
+
+            usz j = 1;
+            while (j < foldedNeedle.size() && FoldTable[u8(haystack[i + j])] == foldedNeedle[j])
+                j++;
+
+            if (j == foldedNeedle.size())
+                return true;
+        }
+
+        return false;
+    }
+
+    i32 CompareFolded(std::string_view lhs, std::string_view rhs)
+    {
+        usz count = std::min(lhs.size(), rhs.size());
+        for (usz i = 0; i < count; ++i)
+        {
+            u8 l = u8(FoldTable[u8(lhs[i])]);
+            u8 r = u8(FoldTable[u8(rhs[i])]);
+            if (l != r)
+                return l < r ? -1 : 1;
+        }
+        return lhs.size() == rhs.size() ? 0 : (lhs.size() < rhs.size() ? -1 : 1);
+    }
+
+    std::string PathToUtf8(const std::filesystem::path& path)
+    {
+        auto u8str = path.u8string();
+        return std::string(reinterpret_cast<const c8*>(u8str.data()), u8str.size());
+    }
+
+// -----------------------------------------------------------------------------
+
+    static u32 ClampUnixTime(i64 seconds)
+    {
+        return u32(std::clamp<i64>(seconds, 0, UINT32_MAX));
+    }
+
+    u32 GetUnixTime()
+    {
+        return ClampUnixTime(std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    EntryMetadata GetEntryMetadata(const std::filesystem::directory_entry& entry, bool isDirectory)
+    {
+        EntryMetadata metadata;
+#ifdef _WIN32
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(entry.path().c_str(), GetFileExInfoStandard, &data))
+            return metadata;
+
+        if (!isDirectory)
+            metadata.size = u64(data.nFileSizeHigh) << 32 | data.nFileSizeLow;
+
+        // FILETIME counts 100ns intervals since 1601
+        u64 fileTime = u64(data.ftLastWriteTime.dwHighDateTime) << 32 | data.ftLastWriteTime.dwLowDateTime;
+        metadata.modified = ClampUnixTime(i64(fileTime / 10'000'000) - 11'644'473'600);
+
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN)        metadata.attributes |= EntryAttributes::Hidden;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_SYSTEM)        metadata.attributes |= EntryAttributes::System;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_READONLY)      metadata.attributes |= EntryAttributes::ReadOnly;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) metadata.attributes |= EntryAttributes::Symlink;
+#else
+        struct stat info;
+        if (lstat(entry.path().c_str(), &info) != 0)
+            return metadata;
+
+        if (!isDirectory)
+            metadata.size = u64(info.st_size);
+        metadata.modified = ClampUnixTime(info.st_mtime);
+
+        if (entry.path().filename().native().starts_with('.'))
+            metadata.attributes |= EntryAttributes::Hidden;
+        if (!(info.st_mode & S_IWUSR))
+            metadata.attributes |= EntryAttributes::ReadOnly;
+        if (S_ISLNK(info.st_mode))
+            metadata.attributes |= EntryAttributes::Symlink;
+#endif
+        return metadata;
+    }
+
+    static bool IsVirtualFilesystem([[maybe_unused]] const std::filesystem::path& path)
+    {
+#ifdef _WIN32
+        return false;
+#else
+        return path == "/proc" || path == "/sys" || path == "/dev" || path == "/run";
+#endif
+    }
+
+    void CrawlFilesystem(const std::filesystem::path& root, const CrawlVisitor& visit,
+        const ExclusionRules* exclusions, std::vector<u64>* pruned)
+    {
+        constexpr auto Options = std::filesystem::directory_options::skip_permission_denied;
+
+        struct Frame
+        {
+            std::filesystem::directory_iterator iter;
+            u32 entry;
+
+            // Path relative to the root with a trailing '/', only tracked
+            // when path rules need it
+            std::string relativePath;
+        };
+
+        if (exclusions && exclusions->Size() == 0)
+            exclusions = nullptr;
+        bool needsPath = exclusions && exclusions->NeedsPath();
+        if (exclusions && pruned)
+            pruned->resize(exclusions->Size());
+
+        // Depth first with an explicit stack, so parents are always
+        // visited before their children and memory is bounded by depth
+
+        std::error_code ec;
+        std::vector<Frame> stack;
+        stack.push_back({ std::filesystem::directory_iterator(root, Options, ec), InvalidEntry });
+
+        std::string relativePath;
+        while (!stack.empty())
+        {
+            auto& frame = stack.back();
+            if (frame.iter == std::filesystem::directory_iterator())
+            {
+                stack.pop_back();
+                continue;
+            }
+
+            const auto& dirEntry = *frame.iter;
+            bool isDirectory = dirEntry.is_directory(ec) && !dirEntry.is_symlink(ec);
+            auto path = dirEntry.path();
+            auto name = PathToUtf8(path.filename());
+            auto metadata = GetEntryMetadata(dirEntry, isDirectory);
+
+            // Excluded entries are dropped here, before directories are opened
+
+            if (exclusions)
+            {
+                if (needsPath)
+                {
+                    relativePath = frame.relativePath;
+                    relativePath.append(name);
+                }
+
+                u32 rule = exclusions->Match(name, relativePath, isDirectory, metadata.attributes);
+
+                if (rule != ExclusionRules::InvalidRule)
+                {
+                    if (pruned)
+                        (*pruned)[rule]++;
+
+                    frame.iter.increment(ec);
+                    if (ec)
+                        frame.iter = {};
+                    continue;
+                }
+            }
+
+            u32 entry = visit(frame.entry, u16(stack.size() - 1), name,
+                isDirectory ? EntryFlags::Directory : u8(0), metadata);
+
+            frame.iter.increment(ec);
+            if (ec)
+                frame.iter = {};
+
+            if (isDirectory && !IsVirtualFilesystem(path))
+            {
+                std::filesystem::directory_iterator children(path, Options, ec);
+                if (!ec)
+                {
+                    if (needsPath)
+                        relativePath.push_back('/');
+                    stack.push_back({ std::move(children), entry, needsPath ? relativePath : std::string() });
+                }
+            }
+        }
+    }
+
+    void IndexFilesystem(Index& index, const std::filesystem::path& root,
+        const ExclusionRules* exclusions, std::vector<u64>* pruned)
+    {
+        index.Clear();
+        index.root = PathToUtf8(root);
+        index.scanTime = GetUnixTime();
+
+        CrawlFilesystem(root, [&](u32 parent, u16, std::string_view name, u8 entryFlags, const EntryMetadata& metadata) {
+            return index.AddEntry(parent, name, entryFlags, metadata);
+        }, exclusions, pruned);
+    }
+
+    static std::filesystem::path Utf8ToPath(std::string_view utf8)
+    {
+        return std::filesystem::path(std::u8string_view(reinterpret_cast<const char8_t*>(utf8.data()), utf8.size()));
+    }
+
+    void RescanFilesystem(Index& index, const Index& previous,
+        const ExclusionRules* exclusions, std::vector<u64>* pruned, RescanStats* stats)
+    {
+        constexpr auto Options = std::filesystem::directory_options::skip_permission_denied;
+
+        index.Clear();
+        index.root = previous.root;
+        index.scanTime = GetUnixTime();
+
+        if (exclusions && exclusions->Size() == 0)
+            exclusions = nullptr;
+        bool needsPath = exclusions && exclusions->NeedsPath();
+        if (exclusions && pruned)
+            pruned->resize(exclusions->Size());
+
+        // Children of every previous entry, the root's children last
+
+        u32 count = previous.Size();
+        u32 rootSlot = count;
+        std::vector<u32> childStarts(usz(count) + 2, 0);
+        for (u32 entry = 0; entry < count; ++entry)
+        {
+            u32 parent = previous.parents[entry];
+            childStarts[(parent == InvalidEntry ? rootSlot : parent) + 1]++;
+        }
+        std::partial_sum(childStarts.begin(), childStarts.end(), childStarts.begin());
+
+        std::vector<u32> children(count);
+        {
+            std::vector<u32> next(childStarts.begin(), childStarts.end() - 1);
+            for (u32 entry = 0; entry < count; ++entry)
+            {
+                u32 parent = previous.parents[entry];
+                children[next[parent == InvalidEntry ? rootSlot : parent]++] = entry;
+            }
+        }
+
+        auto excluded = [&](std::string_view name, std::string_view relativePath, bool isDirectory, u8 entryAttributes) {
+            if (!exclusions)
+                return false;
+
+            u32 rule = exclusions->Match(name, relativePath, isDirectory, entryAttributes);
+            if (rule == ExclusionRules::InvalidRule)
+                return false;
+
+            if (pruned)
+                (*pruned)[rule]++;
+            return true;
+        };
+
+        struct Frame
+        {
+            std::filesystem::path path;
+
+            // Entry in the previous index, rootSlot for the root and
+            // InvalidEntry for directories that are new since
+            u32 previous;
+            u32 entry;
+
+            // Set when the entry's metadata was copied, not read afresh
+            bool copied;
+
+            std::string relativePath;
+        };
+
+        RescanStats counts;
+        std::error_code ec;
+        std::vector<Frame> stack;
+        stack.push_back({ Utf8ToPath(previous.root), rootSlot, InvalidEntry, false, {} });
+
+        std::string relativePath;
+        ankerl::unordered_dense::map<std::string_view, u32> previousDirectories;
+        while (!stack.empty())
+        {
+            Frame frame = std::move(stack.back());
+            stack.pop_back();
+
+            // Adding, removing or renaming a child updates the directory's
+            // time. Times at or after the previous scan started are not
+            // trusted, a second change within the same second goes unseen.
+
+            bool changed = frame.previous == InvalidEntry || frame.previous == rootSlot;
+            if (!changed)
+            {
+                counts.directoriesChecked++;
+                if (frame.copied)
+                {
+                    auto metadata = GetEntryMetadata(std::filesystem::directory_entry(frame.path, ec), true);
+                    index.modifiedTimes[frame.entry] = metadata.modified;
+                    index.attributes[frame.entry] = metadata.attributes;
+                }
+
+                u32 stored = previous.modifiedTimes[frame.previous];
+                u32 current = index.modifiedTimes[frame.entry];
+                changed = !current || current != stored || stored >= previous.scanTime;
+            }
+
+            if (!changed)
+            {
+                for (u32 i = childStarts[frame.previous]; i < childStarts[frame.previous + 1]; ++i)
+                {
+                    u32 child = children[i];
+                    auto name = previous.GetName(child);
+                    bool isDirectory = previous.IsDirectory(child);
+
+                    // Rules may have changed since, so copies are matched
+                    // too. Entries a rule no longer excludes need a full
+                    // rebuild to be found.
+                    if (needsPath)
+                    {
+                        relativePath = frame.relativePath;
+                        relativePath.append(name);
+                    }
+                    if (excluded(name, relativePath, isDirectory, previous.attributes[child]))
+                        continue;
+
+                    u32 entry = index.AddEntry(frame.entry, name, previous.flags[child], previous.GetMetadata(child));
+                    counts.entriesReused++;
+
+                    auto path = frame.path / Utf8ToPath(name);
+                    if (isDirectory && !IsVirtualFilesystem(path))
+                        stack.push_back({ std::move(path), child, entry, true, needsPath ? relativePath + '/' : std::string() });
+                }
+                continue;
+            }
+
+            // Changed directories are listed again, subdirectories that
+            // were seen before are checked in turn and new ones crawled
+
+            counts.directoriesListed++;
+            previousDirectories.clear();
+            if (frame.previous != InvalidEntry)
+            {
+                for (u32 i = childStarts[frame.previous]; i < childStarts[frame.previous + 1]; ++i)
+                {
+                    u32 child = children[i];
+                    if (previous.IsDirectory(child))
+                        previousDirectories.emplace(previous.GetName(child), child);
+                }
+            }
+
+            std::filesystem::directory_iterator iter(frame.path, Options, ec);
+            while (iter != std::filesystem::directory_iterator())
+            {
+                const auto& dirEntry = *iter;
+                bool isDirectory = dirEntry.is_directory(ec) && !dirEntry.is_symlink(ec);
+                auto path = dirEntry.path();
+                auto name = PathToUtf8(path.filename());
+                auto metadata = GetEntryMetadata(dirEntry, isDirectory);
+
+                iter.increment(ec);
+                if (ec)
+                    iter = {};
+
+                if (needsPath)
+                {
+                    relativePath = frame.relativePath;
+                    relativePath.append(name);
+                }
+                if (excluded(name, relativePath, isDirectory, metadata.attributes))
+                    continue;
+
+                u32 entry = index.AddEntry(frame.entry, name, isDirectory ? EntryFlags::Directory : u8(0), metadata);
+                counts.entriesRead++;
+
+                if (isDirectory && !IsVirtualFilesystem(path))
+                {
+                    auto match = previousDirectories.find(std::string_view(name));
+                    u32 before = match != previousDirectories.end() ? match->second : InvalidEntry;
+                    stack.push_back({ std::move(path), before, entry, false, needsPath ? relativePath + '/' : std::string() });
+                }
+            }
+        }
+
+        if (stats)
+            *stats = counts;
+    }
+
+    u64 MakeSortPrefix(u16 depth, std::string_view name)
+    {
+        u64 prefix = u64(depth) << 48;
+        for (u32 i = 0; i < 6 && i < name.size(); ++i)
+            prefix |= u64(u8(FoldChar(name[i]))) << (40 - i * 8);
+        return prefix;
+    }
+
+    namespace
+    {
+        // Sort keys carry a prefix of the (depth, folded name) key inline,
+        // so most comparisons never touch the name data
+
+        struct SortKey
+        {
+            u64 prefix;
+            u32 entry;
+        };
+
+        // Entries sorted by (depth, folded name), or by folded name alone
+        std::vector<SortKey> SortKeys(const Index& index, bool byDepth)
+        {
+            u32 count = index.Size();
+
+            std::vector<SortKey> keys(count);
+            ParallelFor(count, 64 * 1024, [&](u64 begin, u64 end, u32) {
+                for (u32 entry = u32(begin); entry < end; ++entry)
+                {
+                    keys[entry] = { MakeSortPrefix(byDepth ? index.depths[entry] : 0, index.GetName(entry)), entry };
+                }
+            });
+
+            ParallelSort(keys, [&](const SortKey& l, const SortKey& r) {
+                if (l.prefix != r.prefix)
+                    return l.prefix < r.prefix;
+
+                if (i32 cmp = CompareFolded(index.GetName(l.entry), index.GetName(r.entry)))
+                    return cmp < 0;
+
+                return l.entry < r.entry;
+            });
+
+            return keys;
+        }
+    }
+
+    static void BuildDfsOrder(Index& index)
+    {
+        u32 count = index.Size();
+        index.preorder.resize(count);
+        index.postorder.resize(count);
+        index.dfsOrder.resize(count);
+
+        // Descendant counts in one backwards pass, children follow parents
+
+        std::vector<u32> next(count);
+        for (u32 entry = count; entry-- > 0;)
+        {
+            u32 parent = index.parents[entry];
+            if (parent != InvalidEntry)
+                next[parent] += next[entry] + 1;
+        }
+
+        // Each entry takes the next free slot of its parent and reserves
+        // room for its subtree behind it, then next holds its own next free
+        // slot. Post order skips the entry's ancestors, which finish later.
+
+        u32 top = 0;
+        for (u32 entry = 0; entry < count; ++entry)
+        {
+            u32 parent = index.parents[entry];
+            u32& slot = parent == InvalidEntry ? top : next[parent];
+            u32 pre = slot;
+            u32 descendants = next[entry];
+            slot += descendants + 1;
+
+            index.preorder[entry] = pre;
+            index.postorder[entry] = pre + descendants - index.depths[entry];
+            index.dfsOrder[pre] = entry;
+            next[entry] = pre + 1;
+        }
+    }
+
+    // Stores each distinct name once, numbered in name order. Equal names
+    // are adjacent in the name order, apart from names that differ only in
+    // case, which are told apart within their folded run.
+    static void InternNames(Index& index)
+    {
+        u32 count = index.Size();
+
+        decltype(index.nameOffsets) nameOffsets = { 0 };
+        decltype(index.names) names;
+        decltype(index.nameIds) nameIds(count);
+
+        auto getName = [&](u32 id) {
+            return std::string_view(names).substr(nameOffsets[id], nameOffsets[id + 1] - nameOffsets[id]);
+        };
+
+        std::vector<u32> distinct;
+        for (u32 entry : index.nameOrder)
+        {
+            auto name = index.GetName(entry);
+            if (!distinct.empty() && CompareFolded(getName(distinct[0]), name) != 0)
+                distinct.clear();
+
+            u32 id = InvalidEntry;
+            for (u32 existing : distinct)
+            {
+                if (getName(existing) == name)
+                {
+                    id = existing;
+                    break;
+                }
+            }
+
+            if (id == InvalidEntry)
+            {
+                id = u32(nameOffsets.size() - 1);
+                names.append(name);
+                nameOffsets.push_back(u32(names.size()));
+                distinct.push_back(id);
+            }
+
+            nameIds[entry] = id;
+        }
+
+        index.nameOffsets = std::move(nameOffsets);
+        index.names = std::move(names);
+        index.nameIds = std::move(nameIds);
+    }
+
+    void SortIndex(Index& index)
+    {
+        u32 count = index.Size();
+
+        auto keys = SortKeys(index, true);
+
+        // Depth is the primary key, so parents still precede their children
+
+        std::vector<u32> remap(count);
+        ParallelFor(count, 64 * 1024, [&](u64 begin, u64 end, u32) {
+            for (u64 i = begin; i < end; ++i)
+                remap[keys[i].entry] = u32(i);
+        });
+
+        Index sorted;
+        sorted.root = index.root;
+        sorted.scanTime = index.scanTime;
+        sorted.parents.resize(count);
+        sorted.nameOffsets.resize(count + 1);
+        sorted.nameIds.resize(count);
+        sorted.depths.resize(count);
+        sorted.flags.resize(count);
+        sorted.sizes.resize(count);
+        sorted.modifiedTimes.resize(count);
+        sorted.attributes.resize(count);
+        sorted.wordStarts.resize(count);
+        sorted.acronyms.resize(count);
+
+        // Name offsets by a two pass parallel prefix sum over chunks
+
+        constexpr u64 Grain = 64 * 1024;
+        std::vector<u64> chunkBytes((count + Grain - 1) / Grain + 1, 0);
+        ParallelFor(count, Grain, [&](u64 begin, u64 end, u32) {
+            u64 bytes = 0;
+            for (u64 i = begin; i < end; ++i)
+                bytes += index.GetName(keys[i].entry).size();
+            chunkBytes[begin / Grain + 1] = bytes;
+        });
+        std::partial_sum(chunkBytes.begin(), chunkBytes.end(), chunkBytes.begin());
+
+        // Entries own their names until the names are interned below
+        if (chunkBytes.back() > UINT32_MAX)
+            throw std::runtime_error("Index name data exceeds 4 GiB");
+        sorted.names.resize(chunkBytes.back());
+
+        ParallelFor(count, Grain, [&](u64 begin, u64 end, u32) {
+            u32 offset = u32(chunkBytes[begin / Grain]);
+            for (u64 i = begin; i < end; ++i)
+            {
+                u32 entry = keys[i].entry;
+                u32 parent = index.parents[entry];
+                auto name = index.GetName(entry);
+
+                sorted.parents[i] = parent == InvalidEntry ? InvalidEntry : remap[parent];
+                sorted.depths[i] = index.depths[entry];
+                sorted.flags[i] = index.flags[entry];
+                sorted.sizes[i] = index.sizes[entry];
+                sorted.modifiedTimes[i] = index.modifiedTimes[entry];
+                sorted.attributes[i] = index.attributes[entry];
+                sorted.wordStarts[i] = index.wordStarts[entry];
+                sorted.acronyms[i] = index.acronyms[entry];
+                sorted.nameIds[i] = u32(i);
+                sorted.nameOffsets[i] = offset;
+                std::memcpy(sorted.names.data() + offset, name.data(), name.size());
+                offset += u32(name.size());
+            }
+        });
+        sorted.nameOffsets[count] = u32(sorted.names.size());
+
+        // Name order over the final entries, for name and prefix lookups
+
+        keys = SortKeys(sorted, false);
+        sorted.nameOrder.resize(count);
+        ParallelFor(count, 64 * 1024, [&](u64 begin, u64 end, u32) {
+            for (u64 i = begin; i < end; ++i)
+                sorted.nameOrder[i] = keys[i].entry;
+        });
+
+        InternNames(sorted);
+        BuildDfsOrder(sorted);
+
+        index = std::move(sorted);
+    }
+
+// -----------------------------------------------------------------------------
+
+    static constexpr u32 IndexMagic = 0x49534D4E; // "NMSI"
+    static constexpr u32 BlockIndexMagic = 0x42534D4E; // "NMSB"
+    static constexpr u32 IndexVersion = 6;
+
+    // Raw bytes per block, also the unit of random access
+    static constexpr u32 IndexBlockSize = 256 * 1024;
+
+    // Blocks the writer buffers and compresses at once
+    static constexpr u32 IndexBlockBatch = 64;
+
+    struct IndexHeader
+    {
+        u32 magic;
+        u32 version;
+        u32 count;
+        u32 rootSize;
+        u64 namesSize;
+        u32 scanTime;
+        u32 nameCount;
+    };
+
+    // Follows the root in block encoded files. The table lists where each
+    // block ends relative to the first, blocks that would not shrink are
+    // stored as is and recognised by their size.
+    struct BlockTableHeader
+    {
+        u64 rawSize;
+        u64 tableOffset;
+        u32 blockSize;
+        u32 blockCount;
+    };
+
+    static u64 GetRawBlockSize(u64 rawSize, u32 blockSize, u32 block)
+    {
+        return std::min<u64>(blockSize, rawSize - u64(block) * blockSize);
+    }
+
+    static bool DecodeIndexBlock(nova::Span<u8> input, u8* output, u64 rawBytes)
+    {
+        if (input.size() == rawBytes)
+        {
+            std::memcpy(output, input.data(), rawBytes);
+            return true;
+        }
+
+        return DecompressBlock(input, output, rawBytes);
+    }
+
+    bool IsIndexFileCurrent(const std::filesystem::path& file)
+    {
+        std::ifstream in(file, std::ios::binary);
+        IndexHeader header;
+        in.read(reinterpret_cast<c8*>(&header), sizeof(header));
+        return in && (header.magic == IndexMagic || header.magic == BlockIndexMagic) && header.version == IndexVersion;
+    }
+
+// -----------------------------------------------------------------------------
+
+    IndexFileWriter::IndexFileWriter(const std::filesystem::path& _file, IndexEncoding _encoding,
+            u32 count, std::string_view root, u32 nameCount, u64 namesSize, u32 scanTime)
+        : out(_file, std::ios::binary | std::ios::trunc)
+        , file(_file)
+        , encoding(_encoding)
+    {
+        if (!out)
+            throw std::runtime_error(NOVA_FORMAT("Failed to open index file for writing: {}", PathToUtf8(file)));
+
+        IndexHeader header {
+            .magic = encoding == IndexEncoding::Blocks ? BlockIndexMagic : IndexMagic,
+            .version = IndexVersion,
+            .count = count,
+            .rootSize = u32(root.size()),
+            .namesSize = namesSize,
+            .scanTime = scanTime,
+            .nameCount = nameCount,
+        };
+
+        out.write(reinterpret_cast<const c8*>(&header), sizeof(header));
+        out.write(root.data(), std::streamsize(root.size()));
+
+        if (encoding == IndexEncoding::Blocks)
+        {
+            // Patched by Finish once the blocks are written
+            BlockTableHeader table = {};
+            tableHeaderOffset = u64(out.tellp());
+            out.write(reinterpret_cast<const c8*>(&table), sizeof(table));
+            dataOffset = u64(out.tellp());
+
+            pending.reserve(usz(IndexBlockSize) * IndexBlockBatch);
+        }
+    }
+
+    void IndexFileWriter::Write(const void* data, usz size)
+    {
+        if (encoding == IndexEncoding::Raw)
+        {
+            out.write(static_cast<const c8*>(data), std::streamsize(size));
+            return;
+        }
+
+        auto bytes = static_cast<const u8*>(data);
+        usz batch = usz(IndexBlockSize) * IndexBlockBatch;
+        rawSize += size;
+        while (size)
+        {
+            usz take = std::min(size, batch - pending.size());
+            pending.insert(pending.end(), bytes, bytes + take);
+            bytes += take;
+            size -= take;
+
+            if (pending.size() == batch)
+                WriteBlocks(batch);
+        }
+    }
+
+    void IndexFileWriter::WriteBlocks(usz size)
+    {
+        u32 count = u32((size + IndexBlockSize - 1) / IndexBlockSize);
+        std::vector<std::vector<u8>> blocks(count);
+        ParallelFor(count, 1, [&](u64 block, u64, u32) {
+            usz begin = usz(block) * IndexBlockSize;
+            usz rawBytes = std::min<usz>(IndexBlockSize, size - begin);
+
+            auto& output = blocks[block];
+            output.resize(GetMaxCompressedSize(rawBytes));
+            usz compressedBytes = CompressBlock({ pending.data() + begin, rawBytes }, output.data());
+            if (compressedBytes < rawBytes)
+                output.resize(compressedBytes);
+            else
+                output.assign(pending.data() + begin, pending.data() + begin + rawBytes);
+        });
+
+        u64 end = blockEnds.empty() ? 0 : blockEnds.back();
+        for (auto& block : blocks)
+        {
+            out.write(reinterpret_cast<const c8*>(block.data()), std::streamsize(block.size()));
+            end += block.size();
+            blockEnds.push_back(end);
+        }
+
+        pending.erase(pending.begin(), pending.begin() + size);
+    }
+
+    void IndexFileWriter::Finish()
+    {
+        if (encoding == IndexEncoding::Blocks)
+        {
+            if (!pending.empty())
+                WriteBlocks(pending.size());
+
+            BlockTableHeader table {
+                .rawSize = rawSize,
+                .tableOffset = u64(out.tellp()),
+                .blockSize = IndexBlockSize,
+                .blockCount = u32(blockEnds.size()),
+            };
+
+            out.write(reinterpret_cast<const c8*>(blockEnds.data()), std::streamsize(blockEnds.size() * sizeof(u64)));
+            out.seekp(std::streamoff(tableHeaderOffset));
+            out.write(reinterpret_cast<const c8*>(&table), sizeof(table));
+        }
+
+        out.flush();
+        if (!out)
+            throw std::runtime_error(NOVA_FORMAT("Failed to write index file: {}", PathToUtf8(file)));
+    }
+
+// -----------------------------------------------------------------------------
+
+    namespace
+    {
+        // Reads the block table and checks it before anything is sized from
+        // it. The table must lie past the blocks and inside the file, and the
+        // block ends must rise monotonically and stay clear of the table.
+        void ReadBlockEnds(std::ifstream& in, const std::filesystem::path& file,
+            const BlockTableHeader& table, u64 dataOffset, std::vector<u64>& blockEnds)
+        {
+            in.seekg(0, std::ios::end);
+            u64 fileSize = u64(in.tellg());
+            if (!in || table.tableOffset < dataOffset || table.tableOffset > fileSize
+                    || u64(table.blockCount) * sizeof(u64) > fileSize - table.tableOffset)
+                throw std::runtime_error(NOVA_FORMAT("Corrupt index block table in: {}", PathToUtf8(file)));
+
+            blockEnds.resize(table.blockCount);
+            in.seekg(std::streamoff(table.tableOffset));
+            in.read(reinterpret_cast<c8*>(blockEnds.data()), std::streamsize(blockEnds.size() * sizeof(u64)));
+            if (!in)
+                throw std::runtime_error(NOVA_FORMAT("Truncated index file: {}", PathToUtf8(file)));
+
+            if (!std::ranges::is_sorted(blockEnds)
+                    || (!blockEnds.empty() && blockEnds.back() > table.tableOffset - dataOffset))
+                throw std::runtime_error(NOVA_FORMAT("Corrupt index block table in: {}", PathToUtf8(file)));
+        }
+    }
+
+    IndexBlockReader::IndexBlockReader(const std::filesystem::path& _file)
+        : in(_file, std::ios::binary)
+        , file(_file)
+    {
+        if (!in)
+            throw std::runtime_error(NOVA_FORMAT("Failed to open index file: {}", PathToUtf8(file)));
+
+        IndexHeader header;
+        in.read(reinterpret_cast<c8*>(&header), sizeof(header));
+        if (!in || header.magic != BlockIndexMagic || header.version != IndexVersion)
+            throw std::runtime_error(NOVA_FORMAT("Not a block encoded index file: {}", PathToUtf8(file)));
+
+        BlockTableHeader table;
+        in.seekg(header.rootSize, std::ios::cur);
+        in.read(reinterpret_cast<c8*>(&table), sizeof(table));
+        if (!in)
+            throw std::runtime_error(NOVA_FORMAT("Truncated index file: {}", PathToUtf8(file)));
+
+        dataOffset = u64(in.tellg());
+        rawSize = table.rawSize;
+        blockSize = table.blockSize;
+        if (!blockSize || table.blockCount != (rawSize + blockSize - 1) / blockSize)
+            throw std::runtime_error(NOVA_FORMAT("Invalid index file: {}", PathToUtf8(file)));
+
+        ReadBlockEnds(in, file, table, dataOffset, blockEnds);
+    }
+
+    void IndexBlockReader::ReadBlock(u32 block, std::vector<u8>& output)
+    {
+        u64 begin = block ? blockEnds[block - 1] : 0;
+        u64 end = blockEnds[block];
+        if (begin > end)
+            throw std::runtime_error(NOVA_FORMAT("Corrupt index block {} in: {}", block, PathToUtf8(file)));
+
+        compressed.resize(end - begin);
+        in.seekg(std::streamoff(dataOffset + begin));
+        in.read(reinterpret_cast<c8*>(compressed.data()), std::streamsize(compressed.size()));
+
+        output.resize(GetRawBlockSize(rawSize, blockSize, block));
+        if (!in || !DecodeIndexBlock(compressed, output.data(), output.size()))
+            throw std::runtime_error(NOVA_FORMAT("Corrupt index block {} in: {}", block, PathToUtf8(file)));
+    }
+
+// -----------------------------------------------------------------------------
+
+    void SaveIndex(const Index& index, const std::filesystem::path& file, IndexEncoding encoding)
+    {
+        if (index.nameOrder.size() != index.Size())
+            throw std::runtime_error("Index must be sorted before it is saved");
+
+        IndexFileWriter writer(file, encoding, index.Size(), index.root, index.NameCount(), index.names.size(), index.scanTime);
+
+        auto write = [&](const auto& column) {
+            writer.Write(column.data(), column.size() * sizeof(column[0]));
+        };
+
+        write(index.parents);
+        write(index.nameOffsets);
+        write(index.names);
+        write(index.nameIds);
+        write(index.depths);
+        write(index.flags);
+        write(index.sizes);
+        write(index.modifiedTimes);
+        write(index.attributes);
+        write(index.wordStarts);
+        write(index.acronyms);
+        write(index.nameOrder);
+
+        writer.Finish();
+    }
+
+    namespace
+    {
+        struct ColumnBytes
+        {
+            u8* data;
+            u64 size;
+            u64 offset;
+        };
+
+        // Sizes every column for the header and lists them in file order,
+        // with their offsets into the raw column bytes
+        std::array<ColumnBytes, 12> PrepareColumns(Index& index, const IndexHeader& header)
+        {
+            // One arena holds the columns and the derived depth first order,
+            // with a cache line of slack for every allocation. It is filled
+            // here and only read afterwards.
+            u64 arenaBytes = u64(header.count) * Index::EntryBytes
+                + u64(header.nameCount) * sizeof(u32)
+                + sizeof(u32) + header.namesSize + 24 * Arena::Alignment;
+            index.arena = std::make_shared<Arena>(usz(arenaBytes), GetHugePages());
+
+            auto place = [&](auto& column, usz size) {
+                column = std::remove_reference_t<decltype(column)>(ArenaAllocator<u8>(index.arena));
+                column.resize(size);
+            };
+
+            place(index.parents, header.count);
+            place(index.nameOffsets, usz(header.nameCount) + 1);
+            place(index.names, header.namesSize);
+            place(index.nameIds, header.count);
+            place(index.depths, header.count);
+            place(index.flags, header.count);
+            place(index.sizes, header.count);
+            place(index.modifiedTimes, header.count);
+            place(index.attributes, header.count);
+            place(index.wordStarts, header.count);
+            place(index.acronyms, header.count);
+            place(index.nameOrder, header.count);
+            place(index.preorder, header.count);
+            place(index.postorder, header.count);
+            place(index.dfsOrder, header.count);
+
+            u64 offset = 0;
+            auto bytes = [&](auto& column) {
+                ColumnBytes entry { reinterpret_cast<u8*>(column.data()), column.size() * sizeof(column[0]), offset };
+                offset += entry.size;
+                return entry;
+            };
+
+            return {
+                bytes(index.parents),
+                bytes(index.nameOffsets),
+                bytes(index.names),
+                bytes(index.nameIds),
+                bytes(index.depths),
+                bytes(index.flags),
+                bytes(index.sizes),
+                bytes(index.modifiedTimes),
+                bytes(index.attributes),
+                bytes(index.wordStarts),
+                bytes(index.acronyms),
+                bytes(index.nameOrder),
+            };
+        }
+    }
+
+    void LoadIndex(Index& index, const std::filesystem::path& file)
+    {
+        std::ifstream in(file, std::ios::binary);
+        if (!in)
+            throw std::runtime_error(NOVA_FORMAT("Failed to open index file: {}", PathToUtf8(file)));
+
+        IndexHeader header;
+        in.read(reinterpret_cast<c8*>(&header), sizeof(header));
+        if (!in || (header.magic != IndexMagic && header.magic != BlockIndexMagic) || header.version != IndexVersion)
+            throw std::runtime_error(NOVA_FORMAT("Invalid index file: {}", PathToUtf8(file)));
+
+        index.Clear();
+        index.scanTime = header.scanTime;
+        index.root.resize(header.rootSize);
+        in.read(index.root.data(), header.rootSize);
+        auto columns = PrepareColumns(index, header);
+
+        if (header.magic == IndexMagic)
+        {
+            for (auto& column : columns)
+                in.read(reinterpret_cast<c8*>(column.data), std::streamsize(column.size));
+
+            if (!in)
+                throw std::runtime_error(NOVA_FORMAT("Truncated index file: {}", PathToUtf8(file)));
+
+            BuildDfsOrder(index);
+            return;
+        }
+
+        // Read every block in one sequential pass, then decode in parallel
+
+        BlockTableHeader table;
+        in.read(reinterpret_cast<c8*>(&table), sizeof(table));
+        u64 dataOffset = u64(in.tellg());
+
+        u64 rawSize = columns.back().offset + columns.back().size;
+        if (!in || table.rawSize != rawSize || !table.blockSize
+                || table.blockCount != (rawSize + table.blockSize - 1) / table.blockSize)
+            throw std::runtime_error(NOVA_FORMAT("Invalid index file: {}", PathToUtf8(file)));
+
+        std::vector<u64> blockEnds;
+        ReadBlockEnds(in, file, table, dataOffset, blockEnds);
+
+        std::vector<u8> compressed(blockEnds.empty() ? 0 : blockEnds.back());
+        in.seekg(std::streamoff(dataOffset));
+        in.read(reinterpret_cast<c8*>(compressed.data()), std::streamsize(compressed.size()));
+
+        if (!in)
+            throw std::runtime_error(NOVA_FORMAT("Truncated index file: {}", PathToUtf8(file)));
+
+        std::vector<std::vector<u8>> scratch(GetWorkerCount());
+        ParallelFor(table.blockCount, 1, [&](u64 block, u64, u32 worker) {
+            u64 begin = block ? blockEnds[block - 1] : 0;
+            u64 end = blockEnds[block];
+            u64 rawBegin = block * table.blockSize;
+            u64 rawBytes = GetRawBlockSize(rawSize, table.blockSize, u32(block));
+            u64 rawEnd = rawBegin + rawBytes;
+
+            // Blocks within one column decode in place, the rest are split
+            // across columns from scratch
+
+            u8* target = nullptr;
+            for (auto& column : columns)
+            {
+                if (rawBegin >= column.offset && rawEnd <= column.offset + column.size)
+                    target = column.data + (rawBegin - column.offset);
+            }
+
+            if (!target)
+            {
+                scratch[worker].resize(rawBytes);
+                target = scratch[worker].data();
+            }
+
+            if (begin > end || !DecodeIndexBlock({ compressed.data() + begin, usz(end - begin) }, target, rawBytes))
+                throw std::runtime_error(NOVA_FORMAT("Corrupt index block {} in: {}", block, PathToUtf8(file)));
+
+            if (target != scratch[worker].data())
+                return;
+
+            for (auto& column : columns)
+            {
+                u64 from = std::max(rawBegin, column.offset);
+                u64 to = std::min(rawEnd, column.offset + column.size);
+                if (from < to)
+                    std::memcpy(column.data + (from - column.offset), target + (from - rawBegin), to - from);
+            }
+        });
+
+        BuildDfsOrder(index);
+    }
+}
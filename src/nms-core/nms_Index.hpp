@@ -0,0 +1,284 @@
+#pragma once
+
+#include "nms_Arena.hpp"
+
+namespace nms
+{
+    class ExclusionRules;
+
+    constexpr u32 InvalidEntry = UINT32_MAX;
+
+#ifdef _WIN32
+    constexpr c8 PathSeparator = '\\';
+#else
+    constexpr c8 PathSeparator = '/';
+#endif
+
+    namespace EntryFlags
+    {
+        constexpr u8 Directory = 1 << 0;
+    }
+
+    namespace EntryAttributes
+    {
+        constexpr u8 Hidden   = 1 << 0;
+        constexpr u8 System   = 1 << 1;
+        constexpr u8 ReadOnly = 1 << 2;
+        constexpr u8 Symlink  = 1 << 3;
+    }
+
+    struct EntryMetadata
+    {
+        // Always 0 for directories
+        u64 size = 0;
+
+        // Seconds since the Unix epoch, 0 if unknown
+        u32 modified = 0;
+
+        u8 attributes = 0;
+    };
+
+    // Reads size, modification time and attributes in a single call where
+    // the platform allows. Hidden means the hidden attribute on Windows and
+    // a leading dot elsewhere.
+    EntryMetadata GetEntryMetadata(const std::filesystem::directory_entry& entry, bool isDirectory);
+
+    u32 GetUnixTime();
+
+    // Portable flat index. Entries are stored as columns and always ordered
+    // so that a parent precedes all of its children. After SortIndex entries
+    // are ordered by (depth, folded name), which is also the result order.
+    //
+    // Loaded indexes place every column, and the state a Searcher keeps per
+    // entry, in one arena that is released at once on reload. Indexes built
+    // in place grow their columns on the heap.
+
+    struct Index
+    {
+        std::string root;
+
+        // When the crawl that produced the index started, 0 if unknown.
+        // Directories modified at or after this may have changed unseen.
+        u32 scanTime = 0;
+
+        // Null unless loaded
+        std::shared_ptr<Arena> arena;
+
+        ArenaVector<u32> parents;
+
+        // Distinct names, each stored once, and the name id of each entry.
+        // Entries added in place own their names until SortIndex interns
+        // them, which numbers names in name order.
+        ArenaVector<u32> nameOffsets = { 0 };
+        ArenaString names;
+        ArenaVector<u32> nameIds;
+
+        ArenaVector<u16> depths;
+        ArenaVector<u8> flags;
+
+        // Metadata columns, kept apart so filters scan only what they test
+        ArenaVector<u64> sizes;
+        ArenaVector<u32> modifiedTimes;
+        ArenaVector<u8> attributes;
+
+        // Word starts and packed acronyms of names, see nms_Acronyms.hpp
+        ArenaVector<u32> wordStarts;
+        ArenaVector<u64> acronyms;
+
+        // Entries ordered by folded name, ties in entry order. Built by
+        // SortIndex, empty until then.
+        ArenaVector<u32> nameOrder;
+
+        // Depth first pre and post order numbers, visiting children in entry
+        // order, and the entries in pre order. The descendants of an entry
+        // follow it in dfsOrder, so descent is a range check. Derived by
+        // SortIndex and LoadIndex rather than stored.
+        ArenaVector<u32> preorder;
+        ArenaVector<u32> postorder;
+        ArenaVector<u32> dfsOrder;
+
+        u32 Size() const
+        {
+            return u32(parents.size());
+        }
+
+        u32 NameCount() const
+        {
+            return u32(nameOffsets.size() - 1);
+        }
+
+        std::string_view GetUniqueName(u32 id) const
+        {
+            return std::string_view(names).substr(nameOffsets[id], nameOffsets[id + 1] - nameOffsets[id]);
+        }
+
+        std::string_view GetName(u32 entry) const
+        {
+            return GetUniqueName(nameIds[entry]);
+        }
+
+        bool IsDirectory(u32 entry) const
+        {
+            return flags[entry] & EntryFlags::Directory;
+        }
+
+        EntryMetadata GetMetadata(u32 entry) const
+        {
+            return { sizes[entry], modifiedTimes[entry], attributes[entry] };
+        }
+
+        // Fixed bytes per entry, excluding name data
+        static constexpr usz EntryBytes = sizeof(u32) * 2 + sizeof(u16) + sizeof(u8)
+            + sizeof(u64) + sizeof(u32) + sizeof(u8)
+            + sizeof(u32) + sizeof(u64)
+            + sizeof(u32)
+            + sizeof(u32) * 3;
+
+        // Bytes held by all columns, or by the arena holding them
+        u64 GetMemoryUsage() const;
+
+        // Entries named exactly name, or whose name starts with prefix,
+        // compared case insensitively and listed in name order. Binary
+        // searches nameOrder, so a lookup costs O(log n) plus the entries
+        // it returns.
+        nova::Span<u32> FindNamed(std::string_view name) const;
+        nova::Span<u32> FindNamesStartingWith(std::string_view prefix) const;
+
+        bool IsDescendant(u32 entry, u32 ancestor) const
+        {
+            return preorder[ancestor] < preorder[entry] && postorder[entry] < postorder[ancestor];
+        }
+
+        // Descendants of entry in pre order, a subtree of n entries costs
+        // O(n) to visit
+        nova::Span<u32> GetDescendants(u32 entry) const;
+
+        // Appends the entries with the given full path, compared case
+        // insensitively, so names differing only in case all match. The
+        // root itself is not an entry.
+        void FindPath(std::string_view path, std::vector<u32>& entries) const;
+
+        u32 AddEntry(u32 parent, std::string_view name, u8 entryFlags, const EntryMetadata& metadata = {});
+        void GetFullPath(u32 entry, std::string& output) const;
+        std::string GetFullPath(u32 entry) const;
+        void Clear();
+    };
+
+    c8 FoldChar(c8 c);
+    bool ContainsFolded(std::string_view haystack, std::string_view foldedNeedle);
+    i32 CompareFolded(std::string_view lhs, std::string_view rhs);
+    std::string PathToUtf8(const std::filesystem::path& path);
+
+    // Called for every entry below the root, parents before children.
+    // Returns the id that is passed back as parent for the entry's children.
+    // Entries matched by exclusions are skipped without being opened, with
+    // a count per rule added to pruned (sized to the number of rules).
+    using CrawlVisitor = std::function<u32(u32 parent, u16 depth, std::string_view name, u8 entryFlags, const EntryMetadata& metadata)>;
+    void CrawlFilesystem(const std::filesystem::path& root, const CrawlVisitor& visit,
+        const ExclusionRules* exclusions = nullptr, std::vector<u64>* pruned = nullptr);
+
+    void IndexFilesystem(Index& index, const std::filesystem::path& root,
+        const ExclusionRules* exclusions = nullptr, std::vector<u64>* pruned = nullptr);
+
+    struct RescanStats
+    {
+        // Directories whose modification time was compared, and those of
+        // them that were listed again
+        u64 directoriesChecked = 0;
+        u64 directoriesListed = 0;
+
+        // Entries copied from the previous index and entries read afresh
+        u64 entriesReused = 0;
+        u64 entriesRead = 0;
+    };
+
+    // Refreshes previous into index, listing only directories whose
+    // modification time differs from the stored one. The children of
+    // unchanged directories are copied, so files changed in place within
+    // them keep their stored size and time. Like IndexFilesystem, the
+    // result is unsorted.
+    void RescanFilesystem(Index& index, const Index& previous,
+        const ExclusionRules* exclusions = nullptr, std::vector<u64>* pruned = nullptr, RescanStats* stats = nullptr);
+
+    // Packs depth and the first six folded name bytes into an integer that
+    // orders the same as the (depth, folded name) sort key, ties excepted
+    u64 MakeSortPrefix(u16 depth, std::string_view name);
+
+    // Orders entries by (depth, folded name) and builds the name order
+    void SortIndex(Index& index);
+
+    enum class IndexEncoding : u8
+    {
+        // Columns stored as they are in memory
+        Raw,
+
+        // Columns compressed in independent blocks behind a block table,
+        // smaller to copy and to read from slow disks
+        Blocks,
+    };
+
+    void SaveIndex(const Index& index, const std::filesystem::path& file, IndexEncoding encoding = IndexEncoding::Raw);
+
+    // Loads either encoding, block encoded files are decompressed in
+    // parallel on all cores
+    void LoadIndex(Index& index, const std::filesystem::path& file);
+
+    // False if the file is missing or was written by an older version
+    bool IsIndexFileCurrent(const std::filesystem::path& file);
+
+    // Index files are a header and root path followed by the columns in
+    // order: parents, nameOffsets, names, nameIds, depths, flags, sizes,
+    // modifiedTimes, attributes, wordStarts, acronyms, nameOrder. Streaming
+    // builders write the column bytes in that order and the writer applies
+    // the encoding.
+
+    class IndexFileWriter
+    {
+        std::ofstream out;
+        std::filesystem::path file;
+        IndexEncoding encoding;
+
+        // Block encoding buffers raw bytes until a batch of blocks can be
+        // compressed in parallel
+        std::vector<u8> pending;
+        std::vector<u64> blockEnds;
+        u64 tableHeaderOffset = 0;
+        u64 dataOffset = 0;
+        u64 rawSize = 0;
+
+    public:
+        IndexFileWriter(const std::filesystem::path& file, IndexEncoding encoding,
+            u32 count, std::string_view root, u32 nameCount, u64 namesSize, u32 scanTime);
+
+        void Write(const void* data, usz size);
+
+        // Throws if any write failed
+        void Finish();
+
+    private:
+        void WriteBlocks(usz size);
+    };
+
+    // Random access to single blocks of a block encoded index file. Block i
+    // holds the raw column bytes from i * GetBlockSize() onwards.
+
+    class IndexBlockReader
+    {
+        std::ifstream in;
+        std::filesystem::path file;
+        u64 rawSize = 0;
+        u32 blockSize = 0;
+        u64 dataOffset = 0;
+        std::vector<u64> blockEnds;
+        std::vector<u8> compressed;
+
+    public:
+        explicit IndexBlockReader(const std::filesystem::path& file);
+
+        u32 GetBlockCount() const { return u32(blockEnds.size()); }
+        u32 GetBlockSize() const { return blockSize; }
+        u64 GetRawSize() const { return rawSize; }
+
+        void ReadBlock(u32 block, std::vector<u8>& output);
+    };
+}
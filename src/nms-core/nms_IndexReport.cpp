@@ -0,0 +1,162 @@
+#include "nms_IndexReport.hpp"
+#include "nms_Searcher.hpp"
+
+namespace nms
+{
+    IndexReport BuildIndexReport(const Index& index, u32 topDirectoryCount)
+    {
+        IndexReport report;
+        u32 count = index.Size();
+        report.entries = count;
+
+        report.uniqueNames = index.NameCount();
+        report.nameBytes = index.names.size() + (index.nameOffsets.size() + index.nameIds.size() + index.nameOrder.size()) * sizeof(u32);
+        report.structureBytes = u64(count) * (sizeof(u32) + sizeof(u16) + sizeof(u8) + sizeof(u32) * 3);
+        report.metadataBytes = u64(count) * (sizeof(u64) + sizeof(u32) + sizeof(u8));
+        report.wordBytes = u64(count) * (sizeof(u32) + sizeof(u64));
+        report.searcherBytes = u64(count) * Searcher::EntryBytes + report.uniqueNames * Searcher::NameBytes;
+
+        // Children follow their parents, so one backwards pass totals every
+        // subtree
+
+        std::vector<u32> descendants(count);
+        for (u32 entry = count; entry-- > 0;)
+        {
+            u32 parent = index.parents[entry];
+            if (parent != InvalidEntry)
+                descendants[parent] += descendants[entry] + 1;
+        }
+
+        std::vector<u32> directories;
+        for (u32 entry = 0; entry < count; ++entry)
+        {
+            if (index.IsDirectory(entry))
+            {
+                report.directories++;
+                directories.push_back(entry);
+            }
+            else
+            {
+                report.files++;
+            }
+
+            if (index.attributes[entry] & EntryAttributes::Symlink)
+                report.symlinks++;
+            if (index.attributes[entry] & EntryAttributes::Hidden)
+                report.hidden++;
+
+            usz length = index.GetName(entry).size();
+            report.entryNameBytes += length;
+            if (length >= report.nameLengths.size())
+                report.nameLengths.resize(length + 1);
+            report.nameLengths[length]++;
+
+            u16 depth = index.depths[entry];
+            if (depth >= report.depths.size())
+                report.depths.resize(usz(depth) + 1);
+            report.depths[depth]++;
+        }
+
+        usz top = std::min<usz>(topDirectoryCount, directories.size());
+        std::partial_sort(directories.begin(), directories.begin() + top, directories.end(), [&](u32 l, u32 r) {
+            return descendants[l] != descendants[r] ? descendants[l] > descendants[r] : l < r;
+        });
+
+        for (usz i = 0; i < top; ++i)
+            report.topDirectories.push_back({ index.GetFullPath(directories[i]), descendants[directories[i]] });
+
+        return report;
+    }
+
+// -----------------------------------------------------------------------------
+
+    void AppendJsonString(std::string& output, std::string_view value)
+    {
+        static constexpr std::string_view Hex = "0123456789abcdef";
+
+        output += '"';
+        for (c8 c : value)
+        {
+            switch (c)
+            {
+            break;case '"':  output += "\\\"";
+            break;case '\\': output += "\\\\";
+            break;case '\n': output += "\\n";
+            break;case '\r': output += "\\r";
+            break;case '\t': output += "\\t";
+            break;default:
+                if (u8(c) < 0x20)
+                {
+                    output += "\\u00";
+                    output += Hex[u8(c) >> 4];
+                    output += Hex[u8(c) & 15];
+                }
+                else
+                {
+                    output += c;
+                }
+            }
+        }
+        output += '"';
+    }
+
+    static void AppendJsonArray(std::string& output, const std::vector<u64>& values)
+    {
+        output += '[';
+        for (usz i = 0; i < values.size(); ++i)
+        {
+            if (i)
+                output += ", ";
+            output += std::to_string(values[i]);
+        }
+        output += ']';
+    }
+
+    void AppendIndexReportJson(std::string& output, const IndexReport& report, u32 indent)
+    {
+        std::string pad(indent, ' ');
+        auto field = [&](std::string_view name, u64 value, std::string_view extraPad = "") {
+            output += NOVA_FORMAT("{}{}  \"{}\": {},\n", pad, extraPad, name, value);
+        };
+
+        output += "{\n";
+        field("entries", report.entries);
+        field("directories", report.directories);
+        field("files", report.files);
+        field("symlinks", report.symlinks);
+        field("hidden", report.hidden);
+        field("uniqueNames", report.uniqueNames);
+        output += NOVA_FORMAT("{}  \"nameDedupRatio\": {:.2f},\n", pad, f64(report.entries) / f64(std::max<u64>(report.uniqueNames, 1)));
+        field("entryNameBytes", report.entryNameBytes);
+
+        output += pad + "  \"bytes\": {\n";
+        field("names", report.nameBytes, "  ");
+        field("structure", report.structureBytes, "  ");
+        field("metadata", report.metadataBytes, "  ");
+        field("words", report.wordBytes, "  ");
+        field("searcher", report.searcherBytes, "  ");
+        output += NOVA_FORMAT("{}    \"total\": {}\n", pad,
+            report.nameBytes + report.structureBytes + report.metadataBytes + report.wordBytes + report.searcherBytes);
+        output += pad + "  },\n";
+
+        output += pad + "  \"topDirectories\": [";
+        for (usz i = 0; i < report.topDirectories.size(); ++i)
+        {
+            auto& directory = report.topDirectories[i];
+            output += (i ? ",\n" : "\n") + pad + "    { \"path\": ";
+            AppendJsonString(output, directory.path);
+            output += NOVA_FORMAT(", \"descendants\": {} ", directory.descendants) + "}";
+        }
+        output += report.topDirectories.empty() ? "],\n" : "\n" + pad + "  ],\n";
+
+        output += pad + "  \"nameLengths\": ";
+        AppendJsonArray(output, report.nameLengths);
+        output += ",\n";
+
+        output += pad + "  \"depths\": ";
+        AppendJsonArray(output, report.depths);
+        output += "\n";
+
+        output += pad + "}";
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "nms_Index.hpp"
+
+namespace nms
+{
+    // Composition of an index, for tracking growth and finding what is
+    // worth excluding
+
+    struct IndexReport
+    {
+        u64 entries = 0;
+        u64 directories = 0;
+        u64 files = 0;
+        u64 symlinks = 0;
+        u64 hidden = 0;
+
+        // Distinct names, and the name bytes entries would take if each
+        // stored its own
+        u64 uniqueNames = 0;
+        u64 entryNameBytes = 0;
+
+        // Bytes held once loaded: name data, offsets, ids and order, tree
+        // structure (parents, depths, flags, depth first order), metadata
+        // columns, word starts and acronyms, and the per entry and per name
+        // state a Searcher keeps while filtering
+        u64 nameBytes = 0;
+        u64 structureBytes = 0;
+        u64 metadataBytes = 0;
+        u64 wordBytes = 0;
+        u64 searcherBytes = 0;
+
+        struct Directory
+        {
+            std::string path;
+            u64 descendants;
+        };
+
+        // Largest directories by descendant count, largest first
+        std::vector<Directory> topDirectories;
+
+        // Entry counts indexed by name length and by depth
+        std::vector<u64> nameLengths;
+        std::vector<u64> depths;
+    };
+
+    IndexReport BuildIndexReport(const Index& index, u32 topDirectoryCount = 20);
+
+    // Appends the report as a JSON object, with every line after the first
+    // indented by indent spaces
+    void AppendIndexReportJson(std::string& output, const IndexReport& report, u32 indent = 0);
+
+    // Appends value as a quoted JSON string
+    void AppendJsonString(std::string& output, std::string_view value);
+}
@@ -0,0 +1,47 @@
+#include "nms_Memory.hpp"
+
+#ifdef _WIN32
+#  include <nova/core/win32/nova_Win32Include.hpp>
+#  include <psapi.h>
+#  pragma comment(lib, "psapi.lib")
+#else
+#  include <sys/resource.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace nms
+{
+    u64 GetPeakResidentBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters = {};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage = {};
+        getrusage(RUSAGE_SELF, &usage);
+        return u64(usage.ru_maxrss) * 1024;
+#endif
+    }
+
+    void DropFileCache(const std::filesystem::path& file)
+    {
+#ifdef _WIN32
+        // Opening a file unbuffered purges its pages from the cache manager
+        HANDLE handle = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+            OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+        if (handle != INVALID_HANDLE_VALUE)
+            CloseHandle(handle);
+#else
+        i32 fd = open(file.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        // Dirty pages cannot be dropped
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+#endif
+    }
+}
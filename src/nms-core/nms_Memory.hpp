@@ -0,0 +1,15 @@
+#pragma once
+
+#include <nova/core/nova_Core.hpp>
+
+using namespace nova::types;
+
+namespace nms
+{
+    // Peak resident set size of the current process in bytes
+    u64 GetPeakResidentBytes();
+
+    // Best effort removal of a file's pages from the OS file cache, so the
+    // next read comes from disk
+    void DropFileCache(const std::filesystem::path& file);
+}
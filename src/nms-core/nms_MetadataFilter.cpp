@@ -0,0 +1,177 @@
+#include "nms_MetadataFilter.hpp"
+
+namespace nms
+{
+    namespace
+    {
+        enum class Comparison
+        {
+            Less,
+            LessEqual,
+            Greater,
+            GreaterEqual,
+            Equal,
+        };
+
+        struct FilterValue
+        {
+            Comparison comparison;
+            u64 value;
+        };
+
+        bool StartsWithFolded(std::string_view text, std::string_view foldedPrefix)
+        {
+            return text.size() >= foldedPrefix.size() && CompareFolded(text.substr(0, foldedPrefix.size()), foldedPrefix) == 0;
+        }
+
+        // Parses [op]number[unit] where unit is looked up in units by its
+        // folded suffix, an empty suffix uses the first unit
+        std::optional<FilterValue> ParseValue(std::string_view text, std::initializer_list<std::pair<std::string_view, u64>> units)
+        {
+            FilterValue result { Comparison::Equal, 0 };
+            if      (text.starts_with("<=")) { result.comparison = Comparison::LessEqual;    text.remove_prefix(2); }
+            else if (text.starts_with(">=")) { result.comparison = Comparison::GreaterEqual; text.remove_prefix(2); }
+            else if (text.starts_with('<'))  { result.comparison = Comparison::Less;         text.remove_prefix(1); }
+            else if (text.starts_with('>'))  { result.comparison = Comparison::Greater;      text.remove_prefix(1); }
+            else if (text.starts_with('='))  {                                               text.remove_prefix(1); }
+
+            usz digits = 0;
+            while (digits < text.size() && (std::isdigit(u8(text[digits])) || text[digits] == '.'))
+                digits++;
+
+            if (digits == 0)
+                return std::nullopt;
+
+            f64 number = std::strtod(std::string(text.substr(0, digits)).c_str(), nullptr);
+
+            auto suffix = text.substr(digits);
+            for (auto& [name, scale] : units)
+            {
+                if (suffix.empty() || CompareFolded(suffix, name) == 0)
+                {
+                    f64 value = number * f64(scale);
+                    result.value = value >= 1.8e19 ? UINT64_MAX : u64(value);
+                    return result;
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        // Empty ranges are left with min > max
+        template<class T>
+        void Narrow(T& min, T& max, Comparison comparison, T value)
+        {
+            constexpr T Max = std::numeric_limits<T>::max();
+            switch (comparison)
+            {
+                break;case Comparison::Less:
+                    if (value == 0)
+                        min = Max;
+                    else
+                        max = std::min<T>(max, value - 1);
+                break;case Comparison::LessEqual:
+                    max = std::min(max, value);
+                break;case Comparison::Greater:
+                    if (value == Max)
+                        max = 0;
+                    else
+                        min = std::max<T>(min, value + 1);
+                break;case Comparison::GreaterEqual:
+                    min = std::max(min, value);
+                break;case Comparison::Equal:
+                    min = std::max(min, value);
+                    max = std::min(max, value);
+            }
+        }
+    }
+
+    bool MetadataFilter::Parse(std::string_view keyword, u32 now)
+    {
+        if (StartsWithFolded(keyword, "SIZE:"))
+        {
+            auto value = ParseValue(keyword.substr(5), {
+                { "B", 1 }, { "KB", 1ull << 10 }, { "MB", 1ull << 20 }, { "GB", 1ull << 30 }, { "TB", 1ull << 40 },
+                { "K", 1ull << 10 }, { "M", 1ull << 20 }, { "G", 1ull << 30 }, { "T", 1ull << 40 },
+            });
+
+            if (value)
+            {
+                filterSize = true;
+                Narrow(minSize, maxSize, value->comparison, value->value);
+            }
+            return true;
+        }
+
+        if (StartsWithFolded(keyword, "MODIFIED:"))
+        {
+            constexpr u64 Day = 24 * 60 * 60;
+            auto value = ParseValue(keyword.substr(9), {
+                { "D", Day }, { "S", 1 }, { "M", 60 }, { "H", 60 * 60 }, { "W", 7 * Day }, { "Y", 365 * Day },
+            });
+
+            if (value)
+            {
+                // Ages compare the opposite way to times, less than 7 days
+                // old is modified after now - 7d
+
+                filterModified = true;
+                u32 time = u32(value->value >= now ? 0 : now - value->value);
+                switch (value->comparison)
+                {
+                    break;case Comparison::Less:         Narrow(minModified, maxModified, Comparison::Greater, time);
+                    break;case Comparison::LessEqual:    Narrow(minModified, maxModified, Comparison::GreaterEqual, time);
+                    break;case Comparison::Greater:      Narrow(minModified, maxModified, Comparison::Less, time);
+                    break;case Comparison::GreaterEqual: Narrow(minModified, maxModified, Comparison::LessEqual, time);
+                    break;case Comparison::Equal:        Narrow(minModified, maxModified, Comparison::GreaterEqual, time);
+                }
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    bool MetadataFilter::Matches(const Index& index, u32 entry) const
+    {
+        if (filterSize && (index.IsDirectory(entry) || index.sizes[entry] < minSize || index.sizes[entry] > maxSize))
+            return false;
+
+        if (filterModified && (index.modifiedTimes[entry] < minModified || index.modifiedTimes[entry] > maxModified))
+            return false;
+
+        return true;
+    }
+
+    void MetadataFilter::Scan(const Index& index, u32 begin, u32 end, u8* matched) const
+    {
+        // Unsigned wrap-around turns each range test into a single compare
+
+        if (filterSize && minSize <= maxSize)
+        {
+            const u64* sizes = index.sizes.data();
+            const u8* flags = index.flags.data();
+            u64 range = maxSize - minSize;
+            for (u32 i = begin; i < end; ++i)
+                matched[i] = u8((sizes[i] - minSize <= range) & !(flags[i] & EntryFlags::Directory));
+        }
+        else
+        {
+            std::memset(matched + begin, filterSize ? 0 : 1, end - begin);
+        }
+
+        if (filterModified)
+        {
+            if (minModified > maxModified)
+            {
+                std::memset(matched + begin, 0, end - begin);
+                return;
+            }
+
+            const u32* times = index.modifiedTimes.data();
+            u32 range = maxModified - minModified;
+            for (u32 i = begin; i < end; ++i)
+                matched[i] &= u8(times[i] - minModified <= range);
+        }
+    }
+}
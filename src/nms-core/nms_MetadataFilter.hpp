@@ -0,0 +1,43 @@
+#pragma once
+
+#include "nms_Index.hpp"
+
+namespace nms
+{
+    // Keyword filters over the metadata columns, ANDed with the name match:
+    //
+    //   size:>1GB  size:<=10KB  size:4KB   sizes in B, KB, MB, GB or TB (1024 based)
+    //   modified:<7d  modified:>1y         age in s, m, h, d, w or y
+    //
+    // A bare size means equal, a bare age means within. Each filter narrows
+    // an inclusive range, so any number of filters collapse to one range test
+    // per column. Size filters only match files.
+
+    struct MetadataFilter
+    {
+        u64 minSize = 0;
+        u64 maxSize = UINT64_MAX;
+        u32 minModified = 0;
+        u32 maxModified = UINT32_MAX;
+
+        bool filterSize = false;
+        bool filterModified = false;
+
+        bool IsEmpty() const
+        {
+            return !filterSize && !filterModified;
+        }
+
+        // Returns false if the keyword is not a metadata filter. Incomplete
+        // filters, as seen while typing, are consumed without narrowing.
+        bool Parse(std::string_view keyword, u32 now);
+
+        bool Matches(const Index& index, u32 entry) const;
+
+        // Writes 1 for each entry in [begin, end) that passes and 0 for the
+        // rest. Like every scan kernel, matched is indexed by entry and only
+        // [begin, end) is touched. Each column is scanned in its own
+        // branch-free loop so the compiler can vectorize.
+        void Scan(const Index& index, u32 begin, u32 end, u8* matched) const;
+    };
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "nms_ThreadPool.hpp"
+
+namespace nms
+{
+    inline u32 WorkerCountOverride = 0;
+
+    inline u32 GetWorkerCount()
+    {
+        return WorkerCountOverride ? WorkerCountOverride : GetThreadPool().Size();
+    }
+
+    // Limits parallel algorithms to count threads, 0 to use all cores
+    inline void SetWorkerCount(u32 count)
+    {
+        WorkerCountOverride = count;
+    }
+
+    // Splits [0, count) into chunks of at most grain items and runs them across
+    // all cores. fn(begin, end, worker) is called once per chunk, where worker
+    // is a stable id in [0, GetWorkerCount()) for per-thread scratch state.
+    // Chunks run on the shared pool at the caller's priority.
+    template<class Fn>
+    void ParallelFor(u64 count, u64 grain, Fn&& fn)
+    {
+        u32 workers = u32(std::min<u64>(GetWorkerCount(), (count + grain - 1) / std::max<u64>(grain, 1)));
+        if (workers <= 1)
+        {
+            for (u64 begin = 0; begin < count; begin += grain)
+                fn(begin, std::min(begin + grain, count), 0u);
+            return;
+        }
+
+        std::atomic<u64> next = 0;
+        auto run = [&](u32 worker) {
+            for (;;)
+            {
+                u64 begin = next.fetch_add(grain);
+                if (begin >= count)
+                    break;
+                fn(begin, std::min(begin + grain, count), worker);
+            }
+        };
+
+        TaskGroup group;
+        for (u32 i = 1; i < workers; ++i)
+            group.Run([&run, i] { run(i); });
+        run(0);
+        group.Wait();
+    }
+
+// -----------------------------------------------------------------------------
+
+    namespace detail
+    {
+        // Number of elements taken from a in the first diagonal elements of
+        // the stable merge of a and b (merge path partitioning)
+        template<class T, class Less>
+        usz MergePathSplit(const T* a, usz na, const T* b, usz nb, usz diagonal, Less& less)
+        {
+            usz low = diagonal > nb ? diagonal - nb : 0;
+            usz high = std::min(diagonal, na);
+            while (low < high)
+            {
+                usz mid = (low + high + 1) / 2;
+                if (diagonal - mid >= nb || !less(b[diagonal - mid], a[mid - 1]))
+                    low = mid;
+                else
+                    high = mid - 1;
+            }
+            return low;
+        }
+    }
+
+    // Parallel merge sort. Runs are sorted independently, then merged in
+    // rounds where every merge is split into equal sized output ranges so
+    // that all cores stay busy in the final rounds.
+    template<class T, class Less>
+    void ParallelSort(std::vector<T>& items, Less less)
+    {
+        usz count = items.size();
+        u32 workers = GetWorkerCount();
+        if (workers <= 1 || count < 64 * 1024)
+        {
+            std::sort(items.begin(), items.end(), less);
+            return;
+        }
+
+        usz runSize = (count + workers - 1) / workers;
+        ParallelFor(workers, 1, [&](u64 run, u64, u32) {
+            usz begin = std::min(count, run * runSize);
+            usz end = std::min(count, begin + runSize);
+            std::sort(items.begin() + begin, items.begin() + end, less);
+        });
+
+        struct MergeTask
+        {
+            usz begin, mid, end;
+            usz outBegin, outEnd;
+        };
+
+        std::vector<T> scratch(count);
+        T* src = items.data();
+        T* dst = scratch.data();
+        usz pieceSize = std::max<usz>(count / (workers * 4), 16 * 1024);
+
+        std::vector<MergeTask> tasks;
+        for (usz width = runSize; width < count; width *= 2)
+        {
+            tasks.clear();
+            for (usz begin = 0; begin < count; begin += 2 * width)
+            {
+                usz mid = std::min(count, begin + width);
+                usz end = std::min(count, begin + 2 * width);
+                for (usz out = begin; out < end; out += pieceSize)
+                    tasks.push_back({ begin, mid, end, out, std::min(end, out + pieceSize) });
+            }
+
+            ParallelFor(tasks.size(), 1, [&](u64 index, u64, u32) {
+                auto& task = tasks[index];
+                const T* a = src + task.begin;
+                const T* b = src + task.mid;
+                usz na = task.mid - task.begin;
+                usz nb = task.end - task.mid;
+
+                usz a0 = detail::MergePathSplit(a, na, b, nb, task.outBegin - task.begin, less);
+                usz a1 = detail::MergePathSplit(a, na, b, nb, task.outEnd - task.begin, less);
+                usz b0 = task.outBegin - task.begin - a0;
+                usz b1 = task.outEnd - task.begin - a1;
+
+                std::merge(a + a0, a + a1, b + b0, b + b1, dst + task.outBegin, less);
+            });
+
+            std::swap(src, dst);
+        }
+
+        if (src != items.data())
+            std::copy(src, src + count, items.data());
+    }
+}
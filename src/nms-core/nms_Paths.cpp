@@ -0,0 +1,23 @@
+#include "nms_Paths.hpp"
+
+namespace nms
+{
+    std::filesystem::path GetDataDir()
+    {
+#ifdef _WIN32
+        const char* home = getenv("USERPROFILE");
+#else
+        const char* home = getenv("HOME");
+#endif
+        return std::filesystem::path(home ? home : ".") / ".nms";
+    }
+
+    std::filesystem::path GetDaemonSocketPath()
+    {
+#ifndef _WIN32
+        if (const char* runtime = getenv("XDG_RUNTIME_DIR"))
+            return std::filesystem::path(runtime) / "nms-searchd.sock";
+#endif
+        return GetDataDir() / "searchd.sock";
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <nova/core/nova_Core.hpp>
+
+namespace nms
+{
+    // Per-user data directory, %USERPROFILE%\.nms on Windows and $HOME/.nms elsewhere
+    std::filesystem::path GetDataDir();
+
+    std::filesystem::path GetDaemonSocketPath();
+}
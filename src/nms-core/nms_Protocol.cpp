@@ -0,0 +1,241 @@
+#include "nms_Protocol.hpp"
+
+namespace nms::protocol
+{
+    void MessageWriter::Begin(MessageType type)
+    {
+        MessageHeader header {
+            .magic = Magic,
+            .version = Version,
+            .type = type,
+            .size = 0,
+        };
+        buffer.resize(sizeof(header));
+        std::memcpy(buffer.data(), &header, sizeof(header));
+    }
+
+    bool MessageWriter::Send(LocalSocket& socket)
+    {
+        // Patch in payload size and send header and payload in a single write
+
+        u32 size = u32(buffer.size() - sizeof(MessageHeader));
+        std::memcpy(buffer.data() + offsetof(MessageHeader, size), &size, sizeof(size));
+        return socket.Write(buffer.data(), buffer.size());
+    }
+
+    void MessageWriter::U16(u16 value)
+    {
+        auto bytes = reinterpret_cast<const u8*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+    }
+
+    void MessageWriter::U32(u32 value)
+    {
+        auto bytes = reinterpret_cast<const u8*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+    }
+
+    void MessageWriter::U64(u64 value)
+    {
+        auto bytes = reinterpret_cast<const u8*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+    }
+
+    void MessageWriter::String(std::string_view value)
+    {
+        if (value.size() > UINT16_MAX)
+            throw std::runtime_error("Protocol string exceeds 64 KiB");
+
+        U16(u16(value.size()));
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+
+// -----------------------------------------------------------------------------
+
+    const u8* MessageReader::Take(usz count)
+    {
+        if (!valid || size - offset < count)
+        {
+            valid = false;
+            return nullptr;
+        }
+
+        auto ptr = data + offset;
+        offset += count;
+        return ptr;
+    }
+
+    u16 MessageReader::U16()
+    {
+        u16 value = 0;
+        if (auto ptr = Take(sizeof(value)))
+            std::memcpy(&value, ptr, sizeof(value));
+        return value;
+    }
+
+    u32 MessageReader::U32()
+    {
+        u32 value = 0;
+        if (auto ptr = Take(sizeof(value)))
+            std::memcpy(&value, ptr, sizeof(value));
+        return value;
+    }
+
+    u64 MessageReader::U64()
+    {
+        u64 value = 0;
+        if (auto ptr = Take(sizeof(value)))
+            std::memcpy(&value, ptr, sizeof(value));
+        return value;
+    }
+
+    std::string_view MessageReader::String()
+    {
+        u16 length = U16();
+        auto ptr = Take(length);
+        return ptr ? std::string_view(reinterpret_cast<const c8*>(ptr), length) : std::string_view();
+    }
+
+// -----------------------------------------------------------------------------
+
+    bool Receive(LocalSocket& socket, MessageHeader& header, std::vector<u8>& payload)
+    {
+        if (!socket.Read(&header, sizeof(header)))
+            return false;
+
+        if (header.magic != Magic || header.version != Version)
+            return false;
+
+        payload.resize(header.size);
+        return socket.Read(payload.data(), payload.size());
+    }
+
+    void Encode(MessageWriter& writer, const QueryRequest& request)
+    {
+        writer.Begin(MessageType::Query);
+        writer.U32(request.id);
+        writer.U32(request.pageSize);
+        writer.U32(request.limit);
+        writer.U32(u32(request.keywords.size()));
+        for (auto& keyword : request.keywords)
+            writer.String(keyword);
+    }
+
+    void Encode(MessageWriter& writer, const BatchRequest& request)
+    {
+        writer.Begin(MessageType::Batch);
+        writer.U32(request.id);
+        writer.U32(request.pageSize);
+        writer.U32(request.limit);
+        writer.U32(u32(request.queries.size()));
+        for (auto& query : request.queries)
+        {
+            writer.U32(u32(query.size()));
+            for (auto& keyword : query)
+                writer.String(keyword);
+        }
+    }
+
+    void Encode(MessageWriter& writer, const BatchPage& page)
+    {
+        writer.Begin(MessageType::BatchPage);
+        writer.U32(page.id);
+        writer.U32(u32(page.results.size()));
+        for (auto& result : page.results)
+        {
+            writer.U32(result.query);
+            writer.String(result.path);
+        }
+    }
+
+    void Encode(MessageWriter& writer, const ResultPage& page)
+    {
+        writer.Begin(MessageType::Page);
+        writer.U32(page.id);
+        writer.U32(u32(page.paths.size()));
+        for (auto& path : page.paths)
+            writer.String(path);
+    }
+
+    void Encode(MessageWriter& writer, const QueryEnd& end)
+    {
+        writer.Begin(MessageType::End);
+        writer.U32(end.id);
+        writer.U32(end.count);
+        writer.U64(end.serviceNanos);
+    }
+
+    void Encode(MessageWriter& writer, const ErrorMessage& error)
+    {
+        writer.Begin(MessageType::Error);
+        writer.U32(error.id);
+        writer.String(error.message);
+    }
+
+    bool Decode(MessageReader& reader, QueryRequest& request)
+    {
+        request.id = reader.U32();
+        request.pageSize = reader.U32();
+        request.limit = reader.U32();
+        u32 count = reader.U32();
+        request.keywords.clear();
+        for (u32 i = 0; i < count && reader.IsValid(); ++i)
+            request.keywords.emplace_back(reader.String());
+        return reader.IsValid();
+    }
+
+    bool Decode(MessageReader& reader, BatchRequest& request)
+    {
+        request.id = reader.U32();
+        request.pageSize = reader.U32();
+        request.limit = reader.U32();
+        u32 count = reader.U32();
+        request.queries.clear();
+        for (u32 i = 0; i < count && reader.IsValid(); ++i)
+        {
+            auto& query = request.queries.emplace_back();
+            u32 keywords = reader.U32();
+            for (u32 k = 0; k < keywords && reader.IsValid(); ++k)
+                query.emplace_back(reader.String());
+        }
+        return reader.IsValid();
+    }
+
+    bool Decode(MessageReader& reader, BatchPage& page)
+    {
+        page.id = reader.U32();
+        u32 count = reader.U32();
+        page.results.clear();
+        for (u32 i = 0; i < count && reader.IsValid(); ++i)
+        {
+            u32 query = reader.U32();
+            page.results.push_back({ query, std::string(reader.String()) });
+        }
+        return reader.IsValid();
+    }
+
+    bool Decode(MessageReader& reader, ResultPage& page)
+    {
+        page.id = reader.U32();
+        u32 count = reader.U32();
+        page.paths.clear();
+        for (u32 i = 0; i < count && reader.IsValid(); ++i)
+            page.paths.emplace_back(reader.String());
+        return reader.IsValid();
+    }
+
+    bool Decode(MessageReader& reader, QueryEnd& end)
+    {
+        end.id = reader.U32();
+        end.count = reader.U32();
+        end.serviceNanos = reader.U64();
+        return reader.IsValid();
+    }
+
+    bool Decode(MessageReader& reader, ErrorMessage& error)
+    {
+        error.id = reader.U32();
+        error.message = reader.String();
+        return reader.IsValid();
+    }
+}
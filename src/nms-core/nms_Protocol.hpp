@@ -0,0 +1,149 @@
+#pragma once
+
+#include "nms_Socket.hpp"
+
+namespace nms::protocol
+{
+    // Binary protocol spoken between nms-searchd and its clients over a
+    // LocalSocket. Every message is a fixed header followed by a payload.
+    // Integers are in host byte order as both ends share a machine.
+    //
+    //   Client -> Query
+    //   Server -> Page* End          (or Error)
+    //
+    //   Client -> Batch
+    //   Server -> BatchPage* End     (or Error)
+
+    constexpr u32 Magic = 0x44534D4E; // "NMSD"
+    constexpr u16 Version = 1;
+
+    enum class MessageType : u16
+    {
+        Query = 1,
+        Page  = 2,
+        End   = 3,
+        Error = 4,
+        Batch = 5,
+        BatchPage = 6,
+    };
+
+    struct MessageHeader
+    {
+        u32 magic;
+        u16 version;
+        MessageType type;
+        u32 size;
+    };
+
+    struct QueryRequest
+    {
+        u32 id = 0;
+        u32 pageSize = 256;
+        u32 limit = UINT32_MAX;
+        std::vector<std::string> keywords;
+    };
+
+    struct BatchRequest
+    {
+        u32 id = 0;
+        u32 pageSize = 256;
+        u32 limit = UINT32_MAX; // Per query
+        std::vector<std::vector<std::string>> queries;
+    };
+
+    struct BatchResult
+    {
+        u32 query;
+        std::string path;
+    };
+
+    struct BatchPage
+    {
+        u32 id = 0;
+        std::vector<BatchResult> results;
+    };
+
+    struct ResultPage
+    {
+        u32 id = 0;
+        std::vector<std::string> paths;
+    };
+
+    struct QueryEnd
+    {
+        u32 id = 0;
+        u32 count = 0;
+        u64 serviceNanos = 0;
+    };
+
+    struct ErrorMessage
+    {
+        u32 id = 0;
+        std::string message;
+    };
+
+// -----------------------------------------------------------------------------
+
+    class MessageWriter
+    {
+        std::vector<u8> buffer;
+
+    public:
+        void Begin(MessageType type);
+        bool Send(LocalSocket& socket);
+
+        void U16(u16 value);
+        void U32(u32 value);
+        void U64(u64 value);
+        void String(std::string_view value);
+
+        usz Size() const
+        {
+            return buffer.size();
+        }
+    };
+
+    class MessageReader
+    {
+        const u8* data;
+        usz size;
+        usz offset = 0;
+        bool valid = true;
+
+    public:
+        MessageReader(const std::vector<u8>& payload)
+            : data(payload.data())
+            , size(payload.size())
+        {}
+
+        u16 U16();
+        u32 U32();
+        u64 U64();
+        std::string_view String();
+
+        // True if every read so far was within the payload
+        bool IsValid() const
+        {
+            return valid;
+        }
+
+    private:
+        const u8* Take(usz count);
+    };
+
+    bool Receive(LocalSocket& socket, MessageHeader& header, std::vector<u8>& payload);
+
+    void Encode(MessageWriter& writer, const QueryRequest& request);
+    void Encode(MessageWriter& writer, const BatchRequest& request);
+    void Encode(MessageWriter& writer, const ResultPage& page);
+    void Encode(MessageWriter& writer, const BatchPage& page);
+    void Encode(MessageWriter& writer, const QueryEnd& end);
+    void Encode(MessageWriter& writer, const ErrorMessage& error);
+
+    bool Decode(MessageReader& reader, QueryRequest& request);
+    bool Decode(MessageReader& reader, BatchRequest& request);
+    bool Decode(MessageReader& reader, ResultPage& page);
+    bool Decode(MessageReader& reader, BatchPage& page);
+    bool Decode(MessageReader& reader, QueryEnd& end);
+    bool Decode(MessageReader& reader, ErrorMessage& error);
+}
@@ -0,0 +1,739 @@
+#include "nms_Regex.hpp"
+
+namespace nms
+{
+    // Recursive descent over the pattern into a tree of nodes, which is then
+    // compiled back to front into NFA states, each node leading on to the
+    // states compiled after it
+
+    struct RegexParser
+    {
+        using Op = RegexPattern::Op;
+        using ByteSet = RegexPattern::ByteSet;
+
+        static constexpr u32 Unbounded = ~0u;
+
+        struct Node
+        {
+            enum Kind : u8
+            {
+                Empty,
+                Set,
+                Concat,
+                Alternate,
+                Repeat,
+                Begin,
+                End,
+            };
+
+            Kind kind;
+            u32 set = 0;
+            u32 min = 0;
+            u32 max = 0;
+            std::vector<u32> children;
+        };
+
+        RegexPattern& pattern;
+        std::string_view text;
+        usz pos = 0;
+        std::vector<Node> nodes;
+
+        [[noreturn]] void Fail(std::string_view message) const
+        {
+            throw std::runtime_error(NOVA_FORMAT("{} at offset {} in regex: {}", message, pos, text));
+        }
+
+        bool AtEnd() const
+        {
+            return pos >= text.size();
+        }
+
+        c8 Peek() const
+        {
+            return text[pos];
+        }
+
+        u32 AddNode(Node node)
+        {
+            nodes.push_back(std::move(node));
+            return u32(nodes.size() - 1);
+        }
+
+        u32 AddSet(const ByteSet& set, bool negate)
+        {
+            // Folded before negating, so [^a] excludes both cases
+            ByteSet folded;
+            for (u32 byte = 0; byte < 256; ++byte)
+            {
+                if (set.Test(u8(byte)))
+                    folded.Set(u8(FoldChar(c8(byte))));
+            }
+
+            if (negate)
+            {
+                for (auto& word : folded.words)
+                    word = ~word;
+            }
+
+            pattern.sets.push_back(folded);
+            return AddNode({ .kind = Node::Set, .set = u32(pattern.sets.size() - 1) });
+        }
+
+        static bool GetNamedClass(c8 name, ByteSet& set, bool& negated)
+        {
+            auto range = [&](c8 low, c8 high) {
+                for (u32 byte = u8(low); byte <= u8(high); ++byte)
+                    set.Set(u8(byte));
+            };
+
+            switch (name)
+            {
+            break;case 'd': case 'D':
+                range('0', '9');
+            break;case 'w': case 'W':
+                range('0', '9');
+                range('a', 'z');
+                range('A', 'Z');
+                set.Set('_');
+            break;case 's': case 'S':
+                for (c8 c : std::string_view(" \t\n\r\f\v"))
+                    set.Set(u8(c));
+            break;default:
+                return false;
+            }
+
+            negated = name >= 'A' && name <= 'Z';
+            return true;
+        }
+
+        c8 GetEscapedChar(c8 c) const
+        {
+            switch (c)
+            {
+            break;case 'n': return '\n';
+            break;case 'r': return '\r';
+            break;case 't': return '\t';
+            break;case 'f': return '\f';
+            break;case 'v': return '\v';
+            }
+
+            // Punctuation escapes to itself, letters and digits are reserved
+            if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+                Fail(NOVA_FORMAT("unsupported escape \\{}", c));
+
+            return c;
+        }
+
+        c8 TakeEscape()
+        {
+            if (AtEnd())
+                Fail("trailing backslash");
+            return text[pos++];
+        }
+
+// -----------------------------------------------------------------------------
+
+        u32 ParseAlternate()
+        {
+            std::vector<u32> branches{ ParseConcat() };
+            while (!AtEnd() && Peek() == '|')
+            {
+                pos++;
+                branches.push_back(ParseConcat());
+            }
+
+            if (branches.size() == 1)
+                return branches[0];
+
+            return AddNode({ .kind = Node::Alternate, .children = std::move(branches) });
+        }
+
+        u32 ParseConcat()
+        {
+            std::vector<u32> items;
+            while (!AtEnd() && Peek() != '|' && Peek() != ')')
+                items.push_back(ParseRepeat(ParseAtom()));
+
+            if (items.empty())
+                return AddNode({ .kind = Node::Empty });
+
+            if (items.size() == 1)
+                return items[0];
+
+            return AddNode({ .kind = Node::Concat, .children = std::move(items) });
+        }
+
+        u32 ParseAtom()
+        {
+            c8 c = text[pos++];
+            switch (c)
+            {
+            break;case '(':
+                {
+                    // Groups never capture, so the non-capturing form is the same
+                    if (text.substr(pos).starts_with("?:"))
+                        pos += 2;
+
+                    u32 node = ParseAlternate();
+                    if (AtEnd())
+                        Fail("missing ')'");
+                    pos++;
+                    return node;
+                }
+            break;case '[':
+                return ParseClass();
+            break;case '.':
+                {
+                    ByteSet any;
+                    return AddSet(any, true);
+                }
+            break;case '^':
+                return AddNode({ .kind = Node::Begin });
+            break;case '$':
+                return AddNode({ .kind = Node::End });
+            break;case '*': case '+': case '?':
+                pos--;
+                Fail("nothing to repeat");
+            break;case '\\':
+                {
+                    c8 escape = TakeEscape();
+                    ByteSet set;
+                    bool negated;
+                    if (GetNamedClass(escape, set, negated))
+                        return AddSet(set, negated);
+
+                    set.Set(u8(GetEscapedChar(escape)));
+                    return AddSet(set, false);
+                }
+            }
+
+            ByteSet literal;
+            literal.Set(u8(c));
+            return AddSet(literal, false);
+        }
+
+        u32 ParseClass()
+        {
+            bool negate = !AtEnd() && Peek() == '^';
+            if (negate)
+                pos++;
+
+            ByteSet set;
+            bool first = true;
+            for (;;)
+            {
+                if (AtEnd())
+                    Fail("missing ']'");
+
+                // A leading ']' is a member rather than the end
+                c8 c = text[pos++];
+                if (c == ']' && !first)
+                    break;
+                first = false;
+
+                if (c == '\\')
+                {
+                    c8 escape = TakeEscape();
+                    ByteSet named;
+                    bool negated;
+                    if (GetNamedClass(escape, named, negated))
+                    {
+                        for (u32 i = 0; i < named.words.size(); ++i)
+                            set.words[i] |= negated ? ~named.words[i] : named.words[i];
+                        continue;
+                    }
+
+                    c = GetEscapedChar(escape);
+                }
+
+                u8 low = u8(c);
+                u8 high = low;
+                if (pos + 1 < text.size() && Peek() == '-' && text[pos + 1] != ']')
+                {
+                    pos++;
+                    c8 last = text[pos++];
+                    if (last == '\\')
+                        last = GetEscapedChar(TakeEscape());
+
+                    high = u8(last);
+                    if (high < low)
+                        Fail("invalid range");
+                }
+
+                for (u32 byte = low; byte <= high; ++byte)
+                    set.Set(u8(byte));
+            }
+
+            return AddSet(set, negate);
+        }
+
+        // Parses {n}, {n,} or {n,m}. Anything else leaves the brace to be
+        // read as a literal.
+        bool ParseBounds(u32& min, u32& max)
+        {
+            usz close = text.find('}', pos);
+            if (close == std::string_view::npos)
+                return false;
+
+            auto parse = [](std::string_view digits, u32& value) {
+                if (digits.empty() || digits.size() > 9)
+                    return false;
+
+                value = 0;
+                for (c8 digit : digits)
+                {
+                    if (digit < '0' || digit > '9')
+                        return false;
+                    value = value * 10 + u32(digit - '0');
+                }
+                return true;
+            };
+
+            auto body = text.substr(pos + 1, close - pos - 1);
+            usz comma = body.find(',');
+            if (comma == std::string_view::npos)
+            {
+                if (!parse(body, min))
+                    return false;
+                max = min;
+            }
+            else
+            {
+                if (!parse(body.substr(0, comma), min))
+                    return false;
+
+                if (comma + 1 == body.size())
+                    max = Unbounded;
+                else if (!parse(body.substr(comma + 1), max))
+                    return false;
+            }
+
+            if (min > RegexPattern::MaxRepeat || (max != Unbounded && (max > RegexPattern::MaxRepeat || max < min)))
+                Fail("invalid repeat count");
+
+            pos = close + 1;
+            return true;
+        }
+
+        u32 ParseRepeat(u32 atom)
+        {
+            while (!AtEnd())
+            {
+                u32 min, max;
+                c8 c = Peek();
+                if (c == '*')
+                {
+                    min = 0;
+                    max = Unbounded;
+                    pos++;
+                }
+                else if (c == '+')
+                {
+                    min = 1;
+                    max = Unbounded;
+                    pos++;
+                }
+                else if (c == '?')
+                {
+                    min = 0;
+                    max = 1;
+                    pos++;
+                }
+                else if (c != '{' || !ParseBounds(min, max))
+                {
+                    break;
+                }
+
+                // Laziness only changes which match is reported, not whether
+                // there is one
+                if (!AtEnd() && Peek() == '?')
+                    pos++;
+
+                atom = AddNode({ .kind = Node::Repeat, .min = min, .max = max, .children = { atom } });
+            }
+
+            return atom;
+        }
+
+// -----------------------------------------------------------------------------
+
+        u32 AddState(RegexPattern::NfaState state)
+        {
+            if (pattern.nfa.size() >= RegexPattern::MaxNfaStates)
+                Fail("pattern too large");
+
+            pattern.nfa.push_back(state);
+            return u32(pattern.nfa.size() - 1);
+        }
+
+        u32 Compile(u32 index, u32 next)
+        {
+            const Node& node = nodes[index];
+            switch (node.kind)
+            {
+            break;case Node::Empty:
+                return next;
+            break;case Node::Set:
+                return AddState({ .op = Op::Set, .set = node.set, .next = next });
+            break;case Node::Begin:
+                return AddState({ .op = Op::Begin, .next = next });
+            break;case Node::End:
+                return AddState({ .op = Op::End, .next = next });
+            break;case Node::Concat:
+                for (usz i = node.children.size(); i-- > 0;)
+                    next = Compile(node.children[i], next);
+                return next;
+            break;case Node::Alternate:
+                {
+                    u32 entry = Compile(node.children.back(), next);
+                    for (usz i = node.children.size() - 1; i-- > 0;)
+                        entry = AddState({ .op = Op::Split, .next = Compile(node.children[i], next), .alt = entry });
+                    return entry;
+                }
+            break;case Node::Repeat:
+                {
+                    u32 child = node.children[0];
+                    u32 entry = next;
+                    u32 required = node.min;
+                    if (node.max == Unbounded)
+                    {
+                        // The loop state is patched once its body exists,
+                        // one required copy is the first pass of the loop
+                        u32 loop = AddState({ .op = Op::Split, .alt = next });
+                        u32 body = Compile(child, loop);
+                        pattern.nfa[loop].next = body;
+                        entry = required ? body : loop;
+                        required = required ? required - 1 : 0;
+                    }
+                    else
+                    {
+                        // Optional copies nest, each skipping straight to next
+                        for (u32 i = node.min; i < node.max; ++i)
+                            entry = AddState({ .op = Op::Split, .next = Compile(child, entry), .alt = next });
+                    }
+
+                    for (u32 i = 0; i < required; ++i)
+                        entry = Compile(child, entry);
+                    return entry;
+                }
+            }
+
+            return next;
+        }
+
+// -----------------------------------------------------------------------------
+
+        // The folded byte a set holds, if it holds exactly one
+        i32 GetLiteral(u32 index) const
+        {
+            auto& node = nodes[index];
+            if (node.kind != Node::Set)
+                return -1;
+
+            auto& set = pattern.sets[node.set];
+            u32 count = 0;
+            for (u64 word : set.words)
+                count += u32(std::popcount(word));
+            if (count != 1)
+                return -1;
+
+            for (u32 byte = 0; byte < 256; ++byte)
+            {
+                if (set.Test(u8(byte)))
+                    return i32(byte);
+            }
+            return -1;
+        }
+
+        // Appends the runs of literal bytes that every match of the node
+        // contains. Alternatives and optional parts contribute nothing.
+        void CollectLiterals(u32 index, std::vector<std::string>& out) const
+        {
+            auto& node = nodes[index];
+            if (i32 literal = GetLiteral(index); literal >= 0)
+            {
+                out.emplace_back(1, c8(literal));
+                return;
+            }
+
+            if (node.kind == Node::Repeat && node.min > 0)
+            {
+                CollectLiterals(node.children[0], out);
+                return;
+            }
+
+            if (node.kind != Node::Concat)
+                return;
+
+            std::string run;
+            auto flush = [&] {
+                if (!run.empty())
+                    out.push_back(std::move(run));
+                run.clear();
+            };
+
+            for (u32 child : node.children)
+            {
+                if (i32 literal = GetLiteral(child); literal >= 0)
+                {
+                    run += c8(literal);
+                    continue;
+                }
+
+                auto& sub = nodes[child];
+                if (sub.kind == Node::Repeat && sub.min > 0)
+                {
+                    if (i32 literal = GetLiteral(sub.children[0]); literal >= 0)
+                    {
+                        run.append(sub.min, c8(literal));
+                        if (sub.max != sub.min)
+                            flush();
+                        continue;
+                    }
+                }
+
+                // Anchors consume nothing, runs carry on across them
+                if (sub.kind == Node::Begin || sub.kind == Node::End)
+                    continue;
+
+                flush();
+                CollectLiterals(child, out);
+            }
+            flush();
+        }
+    };
+
+// -----------------------------------------------------------------------------
+
+    RegexPattern::RegexPattern(std::string_view pattern)
+    {
+        try
+        {
+            RegexParser parser{ .pattern = *this, .text = pattern };
+            u32 root = parser.ParseAlternate();
+            if (!parser.AtEnd())
+                parser.Fail("unmatched ')'");
+
+            u32 match = parser.AddState({ .op = Op::Match });
+            start = parser.Compile(root, match);
+
+            parser.CollectLiterals(root, literals);
+        }
+        catch (const std::exception& e)
+        {
+            error = e.what();
+            sets.clear();
+            nfa.clear();
+            literals.clear();
+            return;
+        }
+
+        // Longer literals reject more names, and literals found inside a
+        // longer one add nothing. Single bytes cost as much as the automaton.
+
+        std::ranges::stable_sort(literals, [](auto& l, auto& r) { return l.size() > r.size(); });
+        std::vector<std::string> kept;
+        for (auto& literal : literals)
+        {
+            if (literal.size() < 2 || kept.size() == MaxLiterals)
+                continue;
+
+            if (std::ranges::none_of(kept, [&](auto& k) { return k.find(literal) != std::string::npos; }))
+                kept.push_back(std::move(literal));
+        }
+        literals = std::move(kept);
+
+        BuildClasses();
+        BuildDfa();
+    }
+
+    void RegexPattern::BuildClasses()
+    {
+        // Refine one partition of the folded bytes by every set, so bytes
+        // share a class only when no set tells them apart
+
+        std::array<u32, 256> ids = {};
+        u32 count = 1;
+        std::vector<u32> remap;
+        for (auto& set : sets)
+        {
+            remap.assign(count * 2, ~0u);
+            u32 next = 0;
+            for (u32 byte = 0; byte < 256; ++byte)
+            {
+                if (u8(FoldChar(c8(byte))) != byte)
+                    continue;
+
+                u32& id = remap[ids[byte] * 2 + set.Test(u8(byte))];
+                if (id == ~0u)
+                    id = next++;
+                ids[byte] = id;
+            }
+            count = next;
+        }
+
+        classCount = count;
+        for (u32 byte = 0; byte < 256; ++byte)
+            classes[byte] = u8(ids[u8(FoldChar(c8(byte)))]);
+    }
+
+    void RegexPattern::AddClosure(u32 state, bool atStart, bool atEnd, std::vector<u32>& out, std::vector<u32>& marks, u32 mark) const
+    {
+        std::vector<u32> stack{ state };
+        while (!stack.empty())
+        {
+            u32 s = stack.back();
+            stack.pop_back();
+            if (marks[s] == mark)
+                continue;
+            marks[s] = mark;
+
+            auto& node = nfa[s];
+            switch (node.op)
+            {
+            break;case Op::Set:
+                out.push_back(s);
+            break;case Op::Match:
+                out.push_back(s);
+            break;case Op::Split:
+                stack.push_back(node.alt);
+                stack.push_back(node.next);
+            break;case Op::Jump:
+                stack.push_back(node.next);
+            break;case Op::Begin:
+                if (atStart)
+                    stack.push_back(node.next);
+            break;case Op::End:
+                // Kept, so the end of the name can still pass it
+                out.push_back(s);
+                if (atEnd)
+                    stack.push_back(node.next);
+            }
+        }
+    }
+
+    bool RegexPattern::ClosureMatches(const std::vector<u32>& states, bool atStart, std::vector<u32>& marks, u32& mark) const
+    {
+        std::vector<u32> reached;
+        mark++;
+        for (u32 s : states)
+        {
+            if (nfa[s].op == Op::Match)
+                return true;
+
+            if (nfa[s].op == Op::End)
+                AddClosure(nfa[s].next, atStart, true, reached, marks, mark);
+        }
+
+        return std::ranges::any_of(reached, [&](u32 s) { return nfa[s].op == Op::Match; });
+    }
+
+    void RegexPattern::BuildDfa()
+    {
+        std::vector<u32> marks(nfa.size(), 0);
+        u32 mark = 0;
+
+        std::array<u8, 256> representatives = {};
+        for (u32 byte = 256; byte-- > 0;)
+            representatives[classes[byte]] = u8(FoldChar(c8(byte)));
+
+        // States are sorted sets of NFA states, interned by their bytes
+
+        std::vector<std::vector<u32>> states;
+        ankerl::unordered_dense::map<std::string, u32> ids;
+        auto intern = [&](std::vector<u32>& set) {
+            std::ranges::sort(set);
+            std::string key(reinterpret_cast<const c8*>(set.data()), set.size() * sizeof(u32));
+            auto [iter, inserted] = ids.try_emplace(std::move(key), u32(states.size()));
+            if (inserted)
+                states.push_back(set);
+            return iter->second;
+        };
+
+        std::vector<u32> next;
+        AddClosure(start, true, false, next, marks, ++mark);
+        intern(next);
+
+        for (u32 id = 0; id < states.size(); ++id)
+        {
+            if (states.size() > MaxDfaStates)
+            {
+                // Left to the NFA simulation
+                transitions.clear();
+                accepting.clear();
+                return;
+            }
+
+            auto current = states[id];
+            bool matched = std::ranges::any_of(current, [&](u32 s) { return nfa[s].op == Op::Match; });
+            accepting.push_back(matched || ClosureMatches(current, id == 0, marks, mark));
+
+            transitions.resize(usz(id + 1) * classCount, id);
+            if (matched)
+                continue;
+
+            for (u32 c = 0; c < classCount; ++c)
+            {
+                // Unanchored patterns may begin at any byte, so the start
+                // closure joins every step
+                next.clear();
+                mark++;
+                for (u32 s : current)
+                {
+                    if (nfa[s].op == Op::Set && sets[nfa[s].set].Test(representatives[c]))
+                        AddClosure(nfa[s].next, false, false, next, marks, mark);
+                }
+                AddClosure(start, false, false, next, marks, mark);
+
+                transitions[usz(id) * classCount + c] = intern(next);
+            }
+        }
+    }
+
+    bool RegexPattern::MatchesNfa(std::string_view name) const
+    {
+        std::vector<u32> marks(nfa.size(), 0);
+        u32 mark = 0;
+
+        std::vector<u32> current, next;
+        AddClosure(start, true, false, current, marks, ++mark);
+        for (c8 c : name)
+        {
+            if (std::ranges::any_of(current, [&](u32 s) { return nfa[s].op == Op::Match; }))
+                return true;
+
+            u8 folded = u8(FoldChar(c));
+            next.clear();
+            mark++;
+            for (u32 s : current)
+            {
+                if (nfa[s].op == Op::Set && sets[nfa[s].set].Test(folded))
+                    AddClosure(nfa[s].next, false, false, next, marks, mark);
+            }
+            AddClosure(start, false, false, next, marks, mark);
+            std::swap(current, next);
+        }
+
+        return ClosureMatches(current, name.empty(), marks, mark);
+    }
+
+    bool RegexPattern::Matches(std::string_view name) const
+    {
+        if (!error.empty())
+            return false;
+
+        for (auto& literal : literals)
+        {
+            if (!ContainsFolded(name, literal))
+                return false;
+        }
+
+        if (transitions.empty())
+            return MatchesNfa(name);
+
+        u32 state = 0;
+        for (c8 c : name)
+            state = transitions[usz(state) * classCount + classes[u8(c)]];
+        return accepting[state];
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "nms_Index.hpp"
+
+namespace nms
+{
+    // Regular expressions for "re:" keywords, matched case insensitively
+    // against entry names. Supported are literals, '.', classes such as
+    // [a-z0-9_] and [^.], the escapes \d \w \s and their negations, groups,
+    // '|', the repeats '*' '+' '?' {n} {n,} {n,m} and the anchors '^' and
+    // '$'. Unanchored patterns may match anywhere in the name.
+    //
+    // A pattern is parsed into a Thompson NFA, which is turned into a DFA
+    // over byte classes before any name is tested, so matching is one table
+    // lookup per name byte and never backtracks. Patterns whose DFA would
+    // grow past MaxDfaStates fall back to simulating the NFA, which is
+    // still linear in the name length.
+    //
+    // Literals that every match must contain ("REPORT_" and ".XLSX" for
+    // report_\d{4}\.xlsx$) are collected while parsing. Names are checked
+    // for them with the plain substring search first, so the automaton only
+    // runs on the few names holding all of them.
+
+    class RegexPattern
+    {
+    public:
+        static constexpr u32 MaxDfaStates = 4096;
+        static constexpr u32 MaxNfaStates = 64 * 1024;
+        static constexpr u32 MaxRepeat = 1000;
+
+        // Literal prefilters tested per name, longest first
+        static constexpr usz MaxLiterals = 4;
+
+        explicit RegexPattern(std::string_view pattern);
+
+        // Invalid patterns match nothing
+        bool IsValid() const
+        {
+            return error.empty();
+        }
+
+        const std::string& GetError() const
+        {
+            return error;
+        }
+
+        // Folded literals every match contains
+        const std::vector<std::string>& GetLiterals() const
+        {
+            return literals;
+        }
+
+        bool HasDfa() const
+        {
+            return !transitions.empty();
+        }
+
+        bool Matches(std::string_view name) const;
+
+    private:
+        enum class Op : u8
+        {
+            Set,   // Consumes a byte in sets[set]
+            Split, // Continues at next and alt
+            Jump,  // Continues at next
+            Begin, // Passes only at the start of the name
+            End,   // Passes only at the end of the name
+            Match,
+        };
+
+        struct ByteSet
+        {
+            std::array<u64, 4> words = {};
+
+            bool Test(u8 byte) const
+            {
+                return words[byte >> 6] >> (byte & 63) & 1;
+            }
+
+            void Set(u8 byte)
+            {
+                words[byte >> 6] |= 1ull << (byte & 63);
+            }
+        };
+
+        struct NfaState
+        {
+            Op op;
+            u32 set = 0;
+            u32 next = 0;
+            u32 alt = 0;
+        };
+
+        // Byte sets over folded bytes, the input is folded through classes
+        std::vector<ByteSet> sets;
+        std::vector<NfaState> nfa;
+        u32 start = 0;
+
+        std::vector<std::string> literals;
+        std::string error;
+
+        // Class of each name byte, after folding. No pattern set tells the
+        // bytes of a class apart.
+        std::array<u8, 256> classes = {};
+        u32 classCount = 0;
+
+        // Next state by state and byte class, the initial state is zero.
+        // States that already matched, and states that never can, loop onto
+        // themselves, so a name is matched when the state it ends in
+        // accepts.
+        std::vector<u32> transitions;
+        std::vector<u8> accepting;
+
+        friend struct RegexParser;
+
+        void BuildClasses();
+        void BuildDfa();
+
+        // Adds the states reachable from state without consuming a byte,
+        // keeping those that consume, match or wait for the end
+        void AddClosure(u32 state, bool atStart, bool atEnd, std::vector<u32>& out, std::vector<u32>& marks, u32 mark) const;
+        bool ClosureMatches(const std::vector<u32>& states, bool atStart, std::vector<u32>& marks, u32& mark) const;
+
+        bool MatchesNfa(std::string_view name) const;
+    };
+
+    // Regex keywords are written with a leading "re:"
+    constexpr std::string_view RegexPrefix = "re:";
+}
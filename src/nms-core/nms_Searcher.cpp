@@ -0,0 +1,505 @@
+#include "nms_Searcher.hpp"
+#include "nms_Parallel.hpp"
+
+namespace nms
+{
+    void Searcher::SetIndex(const Index& _index)
+    {
+        index = &_index;
+        keywords.clear();
+        nameKeywords.clear();
+        fuzzy.clear();
+        acronyms.clear();
+        regexes.clear();
+        names.clear();
+        scopes.clear();
+        scopeEntries.clear();
+
+        directoryMasks.clear();
+        scores.clear();
+        matched.assign(index->Size(), 1);
+        sparse = false;
+        results.clear();
+        namePasses.clear();
+        nameScores.clear();
+        nameMasks.clear();
+    }
+
+    u32 Searcher::GetNameMask(std::string_view name, u32 known) const
+    {
+        u32 mask = known;
+        for (u32 i = 0; i < nameKeywords.size(); ++i)
+        {
+            if (!(mask & (1u << i)) && ContainsFolded(name, nameKeywords[i]))
+                mask |= 1u << i;
+        }
+        return mask;
+    }
+
+    bool Searcher::PassesName(std::string_view name) const
+    {
+        for (auto& pattern : fuzzy)
+        {
+            if (!pattern.Matches(name))
+                return false;
+        }
+
+        if (!MatchesNames(name))
+            return false;
+
+        for (auto& pattern : regexes)
+        {
+            if (!pattern.Matches(name))
+                return false;
+        }
+
+        return true;
+    }
+
+    u32 Searcher::ScoreName(std::string_view name) const
+    {
+        u32 score = 0;
+        for (auto& pattern : fuzzy)
+            score += pattern.Score(name);
+        return score;
+    }
+
+    bool Searcher::MatchesNames(std::string_view name) const
+    {
+        for (auto& lookup : names)
+        {
+            auto part = lookup.prefix ? name.substr(0, lookup.name.size()) : name;
+            if (CompareFolded(part, lookup.name) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    // Whether path lies strictly below directory
+    static bool IsBelow(std::string_view path, std::string_view directory)
+    {
+        if (path.size() <= directory.size() || CompareFolded(path.substr(0, directory.size()), directory) != 0)
+            return false;
+
+        return directory.ends_with(PathSeparator) || path[directory.size()] == PathSeparator;
+    }
+
+    bool Searcher::MatchesScopes(u32 entry, std::string& path) const
+    {
+        if (scopes.empty())
+            return true;
+
+        if (!scopeEntries.empty())
+        {
+            for (u32 scope : scopeEntries)
+            {
+                if (scope == InvalidEntry || index->IsDescendant(entry, scope))
+                    return true;
+            }
+            return false;
+        }
+
+        index->GetFullPath(entry, path);
+        for (auto& scope : scopes)
+        {
+            if (IsBelow(path, scope))
+                return true;
+        }
+        return false;
+    }
+
+    void Searcher::PropagateDirectoryMasks(u32 rootMask, bool perName)
+    {
+        u32 count = index->Size();
+
+        // Directory names are tested in parallel, or read from the masks of
+        // distinct names, then bits flow from parents to children in index
+        // order, where parents always come first
+
+        directoryMasks.resize(count);
+        ParallelFor(count, 64 * 1024, [&](u64 begin, u64 end, u32) {
+            for (u32 entry = u32(begin); entry < end; ++entry)
+            {
+                if (index->IsDirectory(entry))
+                    directoryMasks[entry] = perName ? nameMasks[index->nameIds[entry]] : GetNameMask(index->GetName(entry));
+            }
+        });
+
+        for (u32 entry = 0; entry < count; ++entry)
+        {
+            if (index->IsDirectory(entry))
+            {
+                u32 parent = index->parents[entry];
+                directoryMasks[entry] |= parent == InvalidEntry ? rootMask : directoryMasks[parent];
+            }
+        }
+    }
+
+    void Searcher::Filter(nova::Span<std::string_view> query)
+    {
+        keywords.clear();
+        nameKeywords.clear();
+        metadataFilter = {};
+        fuzzy.clear();
+        acronyms.clear();
+        regexes.clear();
+        names.clear();
+        scopes.clear();
+        scopeEntries.clear();
+        u32 now = GetUnixTime();
+        for (auto keyword : query)
+        {
+            if (metadataFilter.Parse(keyword, now))
+                continue;
+
+            if (keyword.starts_with(AcronymPrefix))
+            {
+                if (keyword.size() > AcronymPrefix.size())
+                    acronyms.emplace_back(keyword.substr(AcronymPrefix.size()));
+                continue;
+            }
+
+            if (keyword.starts_with(RegexPrefix))
+            {
+                if (keyword.size() > RegexPrefix.size())
+                    regexes.emplace_back(keyword.substr(RegexPrefix.size()));
+                continue;
+            }
+
+            if (keyword.starts_with(NameExactPrefix) || keyword.starts_with(NameStartsPrefix))
+            {
+                if (keyword.size() > NameExactPrefix.size())
+                    names.push_back({ std::string(keyword.substr(NameExactPrefix.size())), keyword.starts_with(NameStartsPrefix) });
+                continue;
+            }
+
+            if (keyword.starts_with(ScopePrefix))
+            {
+                auto scope = keyword.substr(ScopePrefix.size());
+                while (scope.size() > 1 && scope.back() == PathSeparator)
+                    scope.remove_suffix(1);
+                if (!scope.empty())
+                    scopes.emplace_back(scope);
+                continue;
+            }
+
+            if (keyword.starts_with(FuzzyPrefix))
+            {
+                if (keyword.size() > 1)
+                    fuzzy.emplace_back(keyword.substr(1));
+                continue;
+            }
+
+            std::string folded(keyword);
+            for (auto& c : folded)
+                c = FoldChar(c);
+
+            if (nameKeywords.size() < 32 && folded.find(PathSeparator) == std::string::npos)
+                nameKeywords.emplace_back(std::move(folded));
+            else
+                keywords.emplace_back(std::move(folded));
+        }
+
+        u32 count = index->Size();
+
+        // Name lookups and scopes leave the entries found for the narrowest
+        // lookup, or those within the scopes, as the only candidates. The
+        // other lookups and scopes are tested per candidate.
+
+        std::vector<u32> candidates;
+        bool lookup = (!names.empty() || !scopes.empty())
+            && index->nameOrder.size() == count && index->dfsOrder.size() == count;
+        if (lookup)
+        {
+            usz candidateCount = count;
+            nova::Span<u32> narrowest = { index->dfsOrder.data(), usz(count) };
+            for (auto& name : names)
+            {
+                auto found = name.prefix ? index->FindNamesStartingWith(name.name) : index->FindNamed(name.name);
+                if (found.size() < candidateCount)
+                {
+                    narrowest = found;
+                    candidateCount = found.size();
+                }
+            }
+
+            // Scopes at or above the root cover the whole index, and scopes
+            // inside another scope add nothing to it
+
+            auto root = std::string_view(index->root);
+            while (root.size() > 1 && root.back() == PathSeparator)
+                root.remove_suffix(1);
+
+            for (auto& scope : scopes)
+            {
+                if (CompareFolded(root, scope) == 0 || IsBelow(root, scope))
+                {
+                    scopeEntries.assign(1, InvalidEntry);
+                    break;
+                }
+
+                index->FindPath(scope, scopeEntries);
+            }
+
+            std::erase_if(scopeEntries, [&](u32 entry) {
+                return entry != InvalidEntry && !index->IsDirectory(entry);
+            });
+
+            std::ranges::sort(scopeEntries);
+            scopeEntries.erase(std::unique(scopeEntries.begin(), scopeEntries.end()), scopeEntries.end());
+
+            auto resolved = scopeEntries;
+            std::erase_if(scopeEntries, [&](u32 entry) {
+                return entry != InvalidEntry && std::ranges::any_of(resolved, [&](u32 scope) {
+                    return scope == InvalidEntry || index->IsDescendant(entry, scope);
+                });
+            });
+
+            // Scopes that resolve to nothing cover nothing, so match nothing
+
+            usz scopeCount = count;
+            if (!scopes.empty())
+            {
+                scopeCount = 0;
+                for (u32 scope : scopeEntries)
+                    scopeCount += scope == InvalidEntry ? count : index->GetDescendants(scope).size();
+            }
+
+            if (scopeCount < candidateCount)
+            {
+                for (u32 scope : scopeEntries)
+                {
+                    auto descendants = index->GetDescendants(scope);
+                    candidates.insert(candidates.end(), descendants.begin(), descendants.end());
+                }
+            }
+            else
+            {
+                candidates.assign(narrowest.begin(), narrowest.end());
+            }
+
+            for (auto& keyword : nameKeywords)
+                keywords.emplace_back(std::move(keyword));
+            nameKeywords.clear();
+        }
+
+        // Metadata and acronym columns are scanned first, so names are only
+        // tested for entries that pass. Candidates are few, so they are
+        // tested one by one instead.
+
+        sparse = lookup;
+        results.clear();
+        scores.clear();
+
+        if (!lookup)
+        {
+            matched.resize(count);
+            if (metadataFilter.IsEmpty())
+                std::fill(matched.begin(), matched.end(), u8(1));
+            else
+                metadataFilter.Scan(*index, 0, count, matched.data());
+
+            if (!acronyms.empty())
+            {
+                ParallelFor(count, 64 * 1024, [&](u64 begin, u64 end, u32) {
+                    for (auto& pattern : acronyms)
+                        pattern.Scan(*index, u32(begin), u32(end), matched.data());
+                });
+            }
+
+            if (!fuzzy.empty())
+                scores.assign(count, 0);
+
+            if (keywords.empty() && nameKeywords.empty() && fuzzy.empty() && regexes.empty())
+                return;
+        }
+
+        // Without a prefilter every entry is tested, so names are evaluated
+        // once per distinct name instead, unless no name repeats
+
+        u32 nameCount = index->NameCount();
+        bool perName = !lookup && metadataFilter.IsEmpty() && acronyms.empty() && nameCount < count
+            && (!nameKeywords.empty() || !fuzzy.empty() || !regexes.empty() || !names.empty());
+        if (perName)
+        {
+            namePasses.resize(nameCount);
+            nameScores.resize(fuzzy.empty() ? 0 : nameCount);
+            nameMasks.resize(nameKeywords.empty() ? 0 : nameCount);
+            ParallelFor(nameCount, 64 * 1024, [&](u64 begin, u64 end, u32) {
+                for (u32 id = u32(begin); id < end; ++id)
+                {
+                    auto name = index->GetUniqueName(id);
+                    bool passes = PassesName(name);
+                    namePasses[id] = passes;
+
+                    if (passes && !fuzzy.empty())
+                        nameScores[id] = ScoreName(name);
+
+                    // Directory names pass their bits down even when they
+                    // fail themselves
+                    if (!nameKeywords.empty())
+                        nameMasks[id] = GetNameMask(name);
+                }
+            });
+        }
+
+        u32 rootMask = 0;
+        u32 allNames = u32((1ull << nameKeywords.size()) - 1);
+        if (!nameKeywords.empty())
+        {
+            rootMask = GetNameMask(index->root);
+            PropagateDirectoryMasks(rootMask, perName);
+        }
+
+        // Fuzzy names are cheapest to test so they run first, then name
+        // lookups and regexes behind their literal prefilters, then scopes
+        // and names against the bits inherited from the parent, and only
+        // entries that are left build their full path. Survivors are then
+        // scored.
+
+        auto test = [&](u32 entry, std::string& path) -> u8 {
+            u32 id = index->nameIds[entry];
+            std::string_view name;
+            if (!perName)
+                name = index->GetUniqueName(id);
+
+            u8 match = perName ? namePasses[id] : u8(PassesName(name));
+
+            if (match && !MatchesScopes(entry, path))
+                match = 0;
+
+            if (match && allNames)
+            {
+                u32 mask;
+                if (index->IsDirectory(entry))
+                {
+                    mask = directoryMasks[entry];
+                }
+                else
+                {
+                    u32 parent = index->parents[entry];
+                    mask = parent == InvalidEntry ? rootMask : directoryMasks[parent];
+                    if (mask != allNames)
+                        mask = perName ? mask | nameMasks[id] : GetNameMask(name, mask);
+                }
+
+                if (mask != allNames)
+                    match = 0;
+            }
+
+            if (match && !keywords.empty())
+            {
+                index->GetFullPath(entry, path);
+                for (auto& keyword : keywords)
+                {
+                    if (!ContainsFolded(path, keyword))
+                    {
+                        match = 0;
+                        break;
+                    }
+                }
+            }
+
+            return match;
+        };
+
+        auto score = [&](u32 entry) {
+            u32 id = index->nameIds[entry];
+            return perName ? nameScores[id] : ScoreName(index->GetUniqueName(id));
+        };
+
+        std::vector<std::string> paths(GetWorkerCount());
+        if (lookup)
+        {
+            // Candidates are tested in entry order, so the survivors are
+            // listed in order without a second sort
+
+            std::ranges::sort(candidates);
+
+            std::vector<u8> passes(candidates.size());
+            std::vector<u32> candidateScores(fuzzy.empty() ? 0 : candidates.size());
+            ParallelFor(candidates.size(), 4 * 1024, [&](u64 begin, u64 end, u32 worker) {
+                for (u64 i = begin; i < end; ++i)
+                {
+                    u32 entry = candidates[i];
+                    if (!metadataFilter.Matches(*index, entry))
+                        continue;
+                    if (!std::ranges::all_of(acronyms, [&](auto& pattern) { return pattern.Matches(*index, entry); }))
+                        continue;
+
+                    passes[i] = test(entry, paths[worker]);
+                    if (passes[i] && !fuzzy.empty())
+                        candidateScores[i] = score(entry);
+                }
+            });
+
+            for (usz i = 0; i < candidates.size(); ++i)
+            {
+                if (!passes[i])
+                    continue;
+
+                results.push_back(candidates[i]);
+                if (!fuzzy.empty())
+                    scores.push_back(candidateScores[i]);
+            }
+        }
+        else
+        {
+            ParallelFor(count, 64 * 1024, [&](u64 begin, u64 end, u32 worker) {
+                for (u32 entry = u32(begin); entry < end; ++entry)
+                {
+                    if (!matched[entry])
+                        continue;
+
+                    matched[entry] = test(entry, paths[worker]);
+                    if (matched[entry] && !fuzzy.empty())
+                        scores[entry] = score(entry);
+                }
+            });
+        }
+    }
+
+    u32 Searcher::GetScore(u32 entry) const
+    {
+        if (scores.empty())
+            return 0;
+
+        if (!sparse)
+            return scores[entry];
+
+        auto found = std::ranges::lower_bound(results, entry);
+        return (found != results.end() && *found == entry) ? scores[usz(found - results.begin())] : 0;
+    }
+
+    u32 Searcher::FindNext(u32 entry) const
+    {
+        if (sparse)
+        {
+            auto found = entry == InvalidEntry ? results.begin() : std::ranges::upper_bound(results, entry);
+            return found != results.end() ? *found : InvalidEntry;
+        }
+
+        usz start = entry == InvalidEntry ? 0 : usz(entry) + 1;
+        if (start >= matched.size())
+            return InvalidEntry;
+
+        auto found = static_cast<const u8*>(std::memchr(matched.data() + start, 1, matched.size() - start));
+        return found ? u32(found - matched.data()) : InvalidEntry;
+    }
+
+    u32 Searcher::FindPrev(u32 entry) const
+    {
+        if (sparse)
+        {
+            auto found = entry == InvalidEntry ? results.end() : std::ranges::lower_bound(results, entry);
+            return found != results.begin() ? *(found - 1) : InvalidEntry;
+        }
+
+        for (u32 i = entry == InvalidEntry ? u32(matched.size()) : entry; i-- > 0;)
+        {
+            if (matched[i])
+                return i;
+        }
+        return InvalidEntry;
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "nms_Index.hpp"
+#include "nms_MetadataFilter.hpp"
+#include "nms_Fuzzy.hpp"
+#include "nms_Acronyms.hpp"
+#include "nms_Regex.hpp"
+
+namespace nms
+{
+    // CPU searcher over an Index. A query is a set of keywords that must
+    // all appear (case insensitively) in an entry's full path, plus any
+    // metadata filters (see MetadataFilter). Keywords starting with '~' are
+    // fuzzy matched against the entry's name instead (see FuzzyPattern) and
+    // give each match a score. Keywords starting with "ac:" match the
+    // initials of the entry's name (see AcronymPattern), and keywords
+    // starting with "re:" are regular expressions over the name (see
+    // RegexPattern). "name:" keywords match names exactly and "name^"
+    // keywords match the start of names. "in:" keywords restrict results to
+    // the descendants of a directory, given by its full path, and with
+    // several of them results may be below any one.
+    //
+    // A keyword without a path separator can only match inside the root or
+    // inside a single name, so it is tested once per name instead of once
+    // per full path. Directory results are passed down to descendants in
+    // one pass over the parent hierarchy, leaving each entry with a test of
+    // its own name and a lookup of its parent's bits.
+    //
+    // Names repeat across large trees, so when every entry is tested the
+    // name keywords, fuzzy, regex and name lookups are evaluated once per
+    // distinct name of the index, and entries read the result through
+    // their name id.
+    //
+    // Name lookups are answered by binary search over the index's name
+    // order and scopes by the ranges their directories cover in depth first
+    // order. Only the entries found for the narrowest lookup, or within the
+    // scopes if they hold fewer, are tested further, and then name keywords
+    // are tested against full paths, as passing directory bits down would
+    // visit every entry. Their matches are kept as a sorted list, so the
+    // cost follows the candidates rather than the index.
+
+    class Searcher
+    {
+        const Index* index = nullptr;
+        std::vector<std::string> keywords;
+
+        // Keywords tested per name, one bit each, and per directory the bits
+        // matched by it or any ancestor
+        std::vector<std::string> nameKeywords;
+        std::vector<u32> directoryMasks;
+
+        MetadataFilter metadataFilter;
+        std::vector<FuzzyPattern> fuzzy;
+        std::vector<AcronymPattern> acronyms;
+        std::vector<RegexPattern> regexes;
+
+        struct NameLookup
+        {
+            std::string name;
+            bool prefix;
+        };
+        std::vector<NameLookup> names;
+
+        // Scope paths, and the directories they resolve to when the index
+        // has its depth first order. InvalidEntry stands for the root.
+        std::vector<std::string> scopes;
+        std::vector<u32> scopeEntries;
+
+        // Owned by the searcher rather than the index's arena, several
+        // searchers may share an index. Kept across SetIndex so reloads reuse
+        // the memory.
+        std::vector<u8> matched;
+        std::vector<u32> scores;
+
+        // When only candidates are tested, the matches are listed in entry
+        // order instead and scores are kept alongside them, so neither
+        // filtering nor iterating touches state for the whole index
+        bool sparse = false;
+        std::vector<u32> results;
+
+        // Per distinct name: whether the name tests pass, its fuzzy score
+        // and its name keyword bits
+        std::vector<u8> namePasses;
+        std::vector<u32> nameScores;
+        std::vector<u32> nameMasks;
+
+    public:
+        // Per entry state while filtering: match flags, plus scores and
+        // directory bits when fuzzy or name keywords are used
+        static constexpr usz EntryBytes = sizeof(u8) + sizeof(u32) + sizeof(u32);
+
+        // Per distinct name state while filtering over every entry
+        static constexpr usz NameBytes = sizeof(u8) + sizeof(u32) + sizeof(u32);
+
+        void SetIndex(const Index& index);
+        const Index* GetIndex() const { return index; }
+
+        void Filter(nova::Span<std::string_view> query);
+
+        bool IsMatched(u32 entry) const
+        {
+            return sparse ? std::ranges::binary_search(results, entry) : matched[entry] != 0;
+        }
+
+        // Scores are only produced by fuzzy keywords
+        bool HasScores() const
+        {
+            return !fuzzy.empty();
+        }
+
+        u32 GetScore(u32 entry) const;
+
+        // Pass InvalidEntry to start from either end. Returns InvalidEntry
+        // when there are no further matches.
+        u32 FindNext(u32 entry) const;
+        u32 FindPrev(u32 entry) const;
+
+    private:
+        // Bits already known to match are not tested again
+        u32 GetNameMask(std::string_view name, u32 known = 0) const;
+        // Fuzzy, name lookup and regex tests, which depend on the name alone
+        bool PassesName(std::string_view name) const;
+        u32 ScoreName(std::string_view name) const;
+
+        bool MatchesNames(std::string_view name) const;
+        bool MatchesScopes(u32 entry, std::string& path) const;
+        void PropagateDirectoryMasks(u32 rootMask, bool perName);
+    };
+
+    constexpr std::string_view NameExactPrefix = "name:";
+    constexpr std::string_view NameStartsPrefix = "name^";
+    constexpr std::string_view ScopePrefix = "in:";
+}
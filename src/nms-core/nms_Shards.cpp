@@ -0,0 +1,371 @@
+#include "nms_Shards.hpp"
+
+#include "nms_Paths.hpp"
+#include "nms_Parallel.hpp"
+
+#include <nova/core/nova_Debug.hpp>
+
+#ifdef _WIN32
+#  include <nova/core/win32/nova_Win32Include.hpp>
+#endif
+
+namespace nms
+{
+    static std::vector<ShardConfig> GetDefaultShards()
+    {
+        std::vector<ShardConfig> configs;
+#ifdef _WIN32
+        char drives[256];
+        u32 length = GetLogicalDriveStringsA(sizeof(drives), drives);
+        for (char* drive = drives; drive < drives + length && *drive; drive += strlen(drive) + 1)
+        {
+            if (GetDriveTypeA(drive) == DRIVE_FIXED)
+                configs.push_back({ .name = std::string(1, drive[0]), .root = drive });
+        }
+#else
+        configs.push_back({ .name = "root", .root = "/" });
+#endif
+        return configs;
+    }
+
+    std::vector<ShardConfig> LoadShardConfig()
+    {
+        std::ifstream in(GetDataDir() / "shards.txt");
+        if (!in)
+            return GetDefaultShards();
+
+        std::vector<ShardConfig> configs;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream fields(line);
+            ShardConfig config;
+            if (!(fields >> config.name) || config.name.starts_with('#'))
+                continue;
+
+            if (!(fields >> config.rebuildMinutes))
+            {
+                NOVA_LOG("Invalid shard config line: {}", line);
+                continue;
+            }
+
+            // Options up front, the root takes the rest of the line
+            while ((fields >> std::ws).peek() == '+')
+            {
+                std::string option;
+                fields >> option;
+                if (option == "+compress")
+                    config.encoding = IndexEncoding::Blocks;
+                else
+                    NOVA_LOG("Shard [{}] has unknown option: {}", config.name, option);
+            }
+
+            std::string root;
+            std::getline(fields, root);
+            while (!root.empty() && std::isspace(u8(root.back())))
+                root.pop_back();
+
+            if (root.empty())
+            {
+                NOVA_LOG("Shard [{}] has no root", config.name);
+                continue;
+            }
+
+            config.root = root;
+            configs.push_back(std::move(config));
+        }
+
+        return configs;
+    }
+
+    std::filesystem::path GetShardFile(const ShardConfig& config)
+    {
+        return GetDataDir() / "shards" / (config.name + ".bin");
+    }
+
+    bool IsShardDue(const ShardConfig& config)
+    {
+        std::error_code ec;
+        auto modified = std::filesystem::last_write_time(GetShardFile(config), ec);
+        if (ec)
+            return true;
+
+        if (config.rebuildMinutes == 0)
+            return false;
+
+        auto age = std::filesystem::file_time_type::clock::now() - modified;
+        return age >= std::chrono::minutes(config.rebuildMinutes);
+    }
+
+    void BuildShard(const ShardConfig& config, Index& index,
+        const ExclusionRules* exclusions, std::vector<u64>* pruned)
+    {
+        auto file = GetShardFile(config);
+        std::filesystem::create_directories(file.parent_path());
+
+        IndexFilesystem(index, config.root, exclusions, pruned);
+        SortIndex(index);
+
+        // Write to a temporary file first so readers never see a partial shard
+
+        auto temp = file;
+        temp += ".tmp";
+        SaveIndex(index, temp, config.encoding);
+        std::filesystem::rename(temp, file);
+    }
+
+    bool RescanShard(const ShardConfig& config, Index& index,
+        const ExclusionRules* exclusions, std::vector<u64>* pruned, RescanStats* stats)
+    {
+        auto file = GetShardFile(config);
+
+        // A moved root invalidates every stored path
+        Index previous;
+        if (IsIndexFileCurrent(file))
+            LoadIndex(previous, file);
+        if (previous.root != PathToUtf8(config.root))
+        {
+            BuildShard(config, index, exclusions, pruned);
+            return false;
+        }
+
+        RescanFilesystem(index, previous, exclusions, pruned, stats);
+        previous = {};
+        SortIndex(index);
+
+        auto temp = file;
+        temp += ".tmp";
+        SaveIndex(index, temp, config.encoding);
+        std::filesystem::rename(temp, file);
+        return true;
+    }
+
+    void BuildShardExternal(const ShardConfig& config, u64 memoryBudget,
+        const ExclusionRules* exclusions, ExternalBuildStats* stats)
+    {
+        auto file = GetShardFile(config);
+        std::filesystem::create_directories(file.parent_path());
+
+        auto temp = file;
+        temp += ".tmp";
+        auto tempDir = file;
+        tempDir += ".build";
+
+        BuildIndexExternal(config.root, temp, tempDir, memoryBudget, exclusions, stats, config.encoding);
+        std::filesystem::rename(temp, file);
+    }
+
+    static std::filesystem::path GetShardGenerationFile()
+    {
+        return GetDataDir() / "shards" / "generation";
+    }
+
+    u64 ReadShardGeneration()
+    {
+        u64 generation = 0;
+        std::ifstream in(GetShardGenerationFile());
+        in >> generation;
+        return generation;
+    }
+
+    void PublishShardGeneration()
+    {
+        // Watched shards are rebuilt and published from their own threads
+        static std::mutex mutex;
+        std::scoped_lock lock{ mutex };
+
+        auto file = GetShardGenerationFile();
+        std::filesystem::create_directories(file.parent_path());
+
+        auto temp = file;
+        temp += ".tmp";
+        {
+            std::ofstream out(temp, std::ios::trunc);
+            out << ReadShardGeneration() + 1 << '\n';
+            if (!out)
+                throw std::runtime_error(NOVA_FORMAT("Failed to write {}", temp.string()));
+        }
+        std::filesystem::rename(temp, file);
+    }
+
+// -----------------------------------------------------------------------------
+
+    void ShardSet::Load()
+    {
+        auto configs = LoadShardConfig();
+        auto exclusions = LoadExclusionRules();
+
+        shards.clear();
+        for (auto& config : configs)
+        {
+            auto& shard = shards.emplace_back(std::make_unique<Shard>());
+            shard->config = config;
+        }
+
+        ParallelFor(shards.size(), 1, [&](u64 begin, u64, u32) {
+            auto& shard = *shards[begin];
+            try
+            {
+                auto file = GetShardFile(shard.config);
+                if (IsIndexFileCurrent(file))
+                    LoadIndex(shard.index, file);
+                else
+                    BuildShard(shard.config, shard.index, &exclusions);
+            }
+            catch (const std::exception& e)
+            {
+                // An unavailable root should not take down the other shards
+                NOVA_LOG("Failed to load shard [{}]: {}", shard.config.name, e.what());
+                shard.index.Clear();
+            }
+            shard.searcher.SetIndex(shard.index);
+        });
+    }
+
+    void ShardSet::Filter(nova::Span<std::string_view> query)
+    {
+        ParallelFor(shards.size(), 1, [&](u64 begin, u64, u32) {
+            shards[begin]->searcher.Filter(query);
+        });
+    }
+
+    bool ShardSet::IsMatched(ShardCursor cursor) const
+    {
+        return cursor.IsValid() && shards[cursor.shard]->searcher.IsMatched(cursor.entry);
+    }
+
+    i32 ShardSet::Compare(ShardCursor lhs, ShardCursor rhs) const
+    {
+        auto& l = shards[lhs.shard]->index;
+        auto& r = shards[rhs.shard]->index;
+
+        if (l.depths[lhs.entry] != r.depths[rhs.entry])
+            return l.depths[lhs.entry] < r.depths[rhs.entry] ? -1 : 1;
+
+        if (i32 cmp = CompareFolded(l.GetName(lhs.entry), r.GetName(rhs.entry)))
+            return cmp;
+
+        if (lhs.shard != rhs.shard)
+            return lhs.shard < rhs.shard ? -1 : 1;
+
+        return lhs.entry == rhs.entry ? 0 : (lhs.entry < rhs.entry ? -1 : 1);
+    }
+
+    u32 ShardSet::LowerBound(u32 shard, ShardCursor key) const
+    {
+        // Each shard is sorted by the same key, so the merge position of
+        // a foreign cursor can be found by binary search
+
+        u32 low = 0;
+        u32 high = shards[shard]->index.Size();
+        while (low < high)
+        {
+            u32 mid = low + (high - low) / 2;
+            if (Compare({ shard, mid }, key) < 0)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        return low;
+    }
+
+    ShardCursor ShardSet::FindNext(ShardCursor cursor) const
+    {
+        ShardCursor best;
+        for (u32 s = 0; s < shards.size(); ++s)
+        {
+            auto& searcher = shards[s]->searcher;
+
+            u32 entry;
+            if (!cursor.IsValid())
+            {
+                entry = searcher.FindNext(InvalidEntry);
+            }
+            else
+            {
+                u32 start = s == cursor.shard ? cursor.entry + 1 : LowerBound(s, cursor);
+                entry = searcher.FindNext(start == 0 ? InvalidEntry : start - 1);
+            }
+
+            if (entry != InvalidEntry && (!best.IsValid() || Compare({ s, entry }, best) < 0))
+                best = { s, entry };
+        }
+        return best;
+    }
+
+    ShardCursor ShardSet::FindPrev(ShardCursor cursor) const
+    {
+        ShardCursor best;
+        for (u32 s = 0; s < shards.size(); ++s)
+        {
+            auto& searcher = shards[s]->searcher;
+
+            u32 entry;
+            if (!cursor.IsValid())
+                entry = searcher.FindPrev(InvalidEntry);
+            else
+                entry = searcher.FindPrev(s == cursor.shard ? cursor.entry : LowerBound(s, cursor));
+
+            if (entry != InvalidEntry && (!best.IsValid() || Compare({ s, entry }, best) > 0))
+                best = { s, entry };
+        }
+        return best;
+    }
+
+// -----------------------------------------------------------------------------
+
+    void ShardSetBuffer::Load()
+    {
+        // Read first, shards published while loading trigger another reload
+        u64 loadGeneration = ReadShardGeneration();
+
+        auto set = std::make_shared<ShardSet>();
+        set->Load();
+
+        generation.store(loadGeneration, std::memory_order_relaxed);
+        current.store(std::move(set), std::memory_order_release);
+    }
+
+    void ShardSetBuffer::Reload()
+    {
+        if (loading.exchange(true))
+            return;
+
+        loads.Run(TaskPriority::Background, [this] {
+            try
+            {
+                u64 loadGeneration = ReadShardGeneration();
+
+                auto set = std::make_shared<ShardSet>();
+                set->Load();
+
+                std::scoped_lock lock{ loadedMutex };
+                loaded = std::move(set);
+                loadedGeneration = loadGeneration;
+            }
+            catch (const std::exception& e)
+            {
+                NOVA_LOG("Failed to reload shards: {}", e.what());
+                loading = false;
+            }
+        });
+    }
+
+    std::shared_ptr<ShardSet> ShardSetBuffer::Swap()
+    {
+        std::shared_ptr<ShardSet> set;
+        {
+            std::scoped_lock lock{ loadedMutex };
+            if (!loaded)
+                return nullptr;
+
+            set = std::move(loaded);
+            generation.store(loadedGeneration, std::memory_order_relaxed);
+        }
+
+        // The previous set lives on in the hands of any reader still using it
+        current.store(set, std::memory_order_release);
+        loading = false;
+        return set;
+    }
+}
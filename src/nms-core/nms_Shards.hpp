@@ -0,0 +1,175 @@
+#pragma once
+
+#include "nms_Index.hpp"
+#include "nms_Searcher.hpp"
+#include "nms_ExternalBuild.hpp"
+#include "nms_Exclusions.hpp"
+#include "nms_ThreadPool.hpp"
+
+namespace nms
+{
+    // A shard indexes a single root (volume, mount or folder) into its own
+    // file with its own rebuild schedule, so slow roots never hold up others.
+
+    struct ShardConfig
+    {
+        std::string name;
+        std::filesystem::path root;
+
+        // Minimum age before a shard is rebuilt, 0 to only rebuild on request
+        u32 rebuildMinutes = 0;
+
+        IndexEncoding encoding = IndexEncoding::Raw;
+    };
+
+    // Reads <data dir>/shards.txt, one shard per line:
+    //
+    //   # name   rebuild-minutes   [options]   root
+    //   projects 30                            D:\Projects
+    //   nas      1440              +compress   \\server\share
+    //
+    // +compress stores the shard block compressed (IndexEncoding::Blocks).
+    // Without a config, every fixed drive (or / on Linux) becomes a shard.
+    std::vector<ShardConfig> LoadShardConfig();
+
+    std::filesystem::path GetShardFile(const ShardConfig& config);
+
+    bool IsShardDue(const ShardConfig& config);
+
+    // Indexes, sorts and atomically replaces the shard file
+    void BuildShard(const ShardConfig& config, Index& index,
+        const ExclusionRules* exclusions = nullptr, std::vector<u64>* pruned = nullptr);
+
+    // As BuildShard, but starts from the existing shard file and lists only
+    // directories that changed since (see RescanFilesystem). Falls back to
+    // a full build when there is no current shard file, returning false.
+    bool RescanShard(const ShardConfig& config, Index& index,
+        const ExclusionRules* exclusions = nullptr, std::vector<u64>* pruned = nullptr, RescanStats* stats = nullptr);
+
+    // As BuildShard, but streams through sorted runs on disk to stay within
+    // memoryBudget bytes regardless of the size of the tree
+    void BuildShardExternal(const ShardConfig& config, u64 memoryBudget,
+        const ExclusionRules* exclusions = nullptr, ExternalBuildStats* stats = nullptr);
+
+    // nms-index bumps a counter in <data dir>/shards/generation once it has
+    // replaced shard files, telling running searches to reload them. A
+    // missing counter reads as 0.
+    u64 ReadShardGeneration();
+    void PublishShardGeneration();
+
+// -----------------------------------------------------------------------------
+
+    struct Shard
+    {
+        ShardConfig config;
+        Index index;
+        Searcher searcher;
+    };
+
+    struct ShardCursor
+    {
+        u32 shard = InvalidEntry;
+        u32 entry = InvalidEntry;
+
+        bool IsValid() const
+        {
+            return shard != InvalidEntry;
+        }
+    };
+
+    // Fans queries out to all shards in parallel and presents their results
+    // as a single stream in (depth, folded name, shard) order.
+
+    class ShardSet
+    {
+        std::vector<std::unique_ptr<Shard>> shards;
+
+    public:
+        // Loads every configured shard in parallel, building missing shards
+        void Load();
+
+        u32 Size() const
+        {
+            return u32(shards.size());
+        }
+
+        const Shard& operator[](u32 shard) const
+        {
+            return *shards[shard];
+        }
+
+        void Filter(nova::Span<std::string_view> query);
+
+        bool IsMatched(ShardCursor cursor) const;
+
+        // True if the last query produced match scores (fuzzy keywords)
+        bool HasScores() const
+        {
+            return !shards.empty() && shards[0]->searcher.HasScores();
+        }
+
+        u32 GetScore(ShardCursor cursor) const
+        {
+            return shards[cursor.shard]->searcher.GetScore(cursor.entry);
+        }
+
+        // Pass an invalid cursor to start from either end
+        ShardCursor FindNext(ShardCursor cursor) const;
+        ShardCursor FindPrev(ShardCursor cursor) const;
+
+        std::string GetFullPath(ShardCursor cursor) const
+        {
+            return shards[cursor.shard]->index.GetFullPath(cursor.entry);
+        }
+
+    private:
+        i32 Compare(ShardCursor lhs, ShardCursor rhs) const;
+        u32 LowerBound(u32 shard, ShardCursor key) const;
+    };
+
+// -----------------------------------------------------------------------------
+
+    // Double buffered shard sets, replaced without blocking queries. Reload
+    // loads a second set in the background while queries keep running on
+    // the current one, and Swap publishes it with a single atomic store.
+    // Readers hold the set they started with until they are done, so a set
+    // that is swapped out is freed once its last reader lets go.
+
+    class ShardSetBuffer
+    {
+        std::atomic<std::shared_ptr<ShardSet>> current;
+        std::atomic<u64> generation = 0;
+
+        // A finished reload waiting for Swap
+        std::mutex loadedMutex;
+        std::shared_ptr<ShardSet> loaded;
+        u64 loadedGeneration = 0;
+        std::atomic<bool> loading = false;
+
+        // Declared last, waits for a running reload before anything is destroyed
+        TaskGroup loads;
+
+    public:
+        std::shared_ptr<ShardSet> Get() const
+        {
+            return current.load(std::memory_order_acquire);
+        }
+
+        // Loads and publishes a set on the calling thread
+        void Load();
+
+        // Starts loading a replacement in the background, unless one is
+        // already loading or waiting to be swapped in
+        void Reload();
+
+        // Publishes a finished reload and returns it, null if none is ready.
+        // The caller re-runs its query against the new set.
+        std::shared_ptr<ShardSet> Swap();
+
+        // True if shards were published since the current set was loaded
+        bool IsOutdated() const
+        {
+            return ReadShardGeneration() != generation.load(std::memory_order_relaxed);
+        }
+    };
+}
@@ -0,0 +1,161 @@
+#include "nms_Socket.hpp"
+
+#include <nova/core/nova_Debug.hpp>
+
+#ifdef _WIN32
+#  include <winsock2.h>
+#  include <afunix.h>
+#  pragma comment(lib, "ws2_32.lib")
+#else
+#  include <sys/socket.h>
+#  include <sys/un.h>
+#  include <unistd.h>
+#endif
+
+namespace nms
+{
+#ifdef _WIN32
+    static void InitSockets()
+    {
+        static bool initialized = [] {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        if (!initialized)
+            throw std::runtime_error("Failed to initialize Winsock");
+    }
+
+    static void CloseHandle(uintptr_t handle)
+    {
+        closesocket(SOCKET(handle));
+    }
+#else
+    static void InitSockets() {}
+
+    static void CloseHandle(i32 handle)
+    {
+        close(handle);
+    }
+#endif
+
+    static sockaddr_un MakeAddress(const std::filesystem::path& path)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+
+        auto str = path.string();
+        if (str.size() >= sizeof(address.sun_path))
+            throw std::runtime_error(NOVA_FORMAT("Socket path too long: {}", str));
+
+        std::memcpy(address.sun_path, str.c_str(), str.size() + 1);
+        return address;
+    }
+
+    LocalSocket::LocalSocket(LocalSocket&& other) noexcept
+        : handle(std::exchange(other.handle, InvalidHandle))
+    {}
+
+    LocalSocket& LocalSocket::operator=(LocalSocket&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            handle = std::exchange(other.handle, InvalidHandle);
+        }
+        return *this;
+    }
+
+    LocalSocket::~LocalSocket()
+    {
+        Close();
+    }
+
+    void LocalSocket::Close()
+    {
+        if (handle != InvalidHandle)
+        {
+            CloseHandle(handle);
+            handle = InvalidHandle;
+        }
+    }
+
+    LocalSocket LocalSocket::Listen(const std::filesystem::path& path)
+    {
+        InitSockets();
+
+        auto address = MakeAddress(path);
+
+        // Remove a stale socket left behind by a previous instance
+
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+
+        LocalSocket socket(Handle(::socket(AF_UNIX, SOCK_STREAM, 0)));
+        if (!socket)
+            throw std::runtime_error("Failed to create socket");
+
+        if (::bind(socket.handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+            throw std::runtime_error(NOVA_FORMAT("Failed to bind socket: {}", path.string()));
+
+        if (::listen(socket.handle, SOMAXCONN) != 0)
+            throw std::runtime_error(NOVA_FORMAT("Failed to listen on socket: {}", path.string()));
+
+        return socket;
+    }
+
+    LocalSocket LocalSocket::Connect(const std::filesystem::path& path)
+    {
+        InitSockets();
+
+        auto address = MakeAddress(path);
+
+        LocalSocket socket(Handle(::socket(AF_UNIX, SOCK_STREAM, 0)));
+        if (!socket)
+            throw std::runtime_error("Failed to create socket");
+
+        if (::connect(socket.handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+            throw std::runtime_error(NOVA_FORMAT("Failed to connect to {}, is nms-searchd running?", path.string()));
+
+        return socket;
+    }
+
+    LocalSocket LocalSocket::Accept()
+    {
+        return LocalSocket(Handle(::accept(handle, nullptr, nullptr)));
+    }
+
+    bool LocalSocket::Read(void* data, usz size)
+    {
+        auto bytes = static_cast<c8*>(data);
+        while (size > 0)
+        {
+            auto count = ::recv(handle, bytes, i32(std::min<usz>(size, INT32_MAX)), 0);
+            if (count <= 0)
+                return false;
+
+            bytes += count;
+            size -= usz(count);
+        }
+        return true;
+    }
+
+    bool LocalSocket::Write(const void* data, usz size)
+    {
+#ifdef _WIN32
+        constexpr i32 Flags = 0;
+#else
+        constexpr i32 Flags = MSG_NOSIGNAL;
+#endif
+        auto bytes = static_cast<const c8*>(data);
+        while (size > 0)
+        {
+            auto count = ::send(handle, bytes, i32(std::min<usz>(size, INT32_MAX)), Flags);
+            if (count <= 0)
+                return false;
+
+            bytes += count;
+            size -= usz(count);
+        }
+        return true;
+    }
+}
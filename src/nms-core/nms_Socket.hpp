@@ -0,0 +1,49 @@
+#pragma once
+
+#include <nova/core/nova_Core.hpp>
+
+using namespace nova::types;
+
+namespace nms
+{
+    // Stream socket bound to a local filesystem path (AF_UNIX). Available on
+    // Linux and on Windows 10 1803+, so the daemon protocol is identical on both.
+
+    class LocalSocket
+    {
+#ifdef _WIN32
+        using Handle = uintptr_t;
+        static constexpr Handle InvalidHandle = ~Handle(0);
+#else
+        using Handle = i32;
+        static constexpr Handle InvalidHandle = -1;
+#endif
+        Handle handle = InvalidHandle;
+
+        explicit LocalSocket(Handle _handle)
+            : handle(_handle)
+        {}
+
+    public:
+        LocalSocket() = default;
+        LocalSocket(LocalSocket&& other) noexcept;
+        LocalSocket& operator=(LocalSocket&& other) noexcept;
+        ~LocalSocket();
+
+        static LocalSocket Listen(const std::filesystem::path& path);
+        static LocalSocket Connect(const std::filesystem::path& path);
+
+        LocalSocket Accept();
+
+        // Returns false if the peer closed the connection before size bytes were read
+        bool Read(void* data, usz size);
+        bool Write(const void* data, usz size);
+
+        void Close();
+
+        explicit operator bool() const
+        {
+            return handle != InvalidHandle;
+        }
+    };
+}
@@ -0,0 +1,328 @@
+#include "nms_ThreadPool.hpp"
+
+#include <nova/core/nova_Guards.hpp>
+
+namespace nms
+{
+    namespace
+    {
+        constexpr u32 NotAWorker = ~0u;
+
+        thread_local const ThreadPool* CurrentPool = nullptr;
+        thread_local u32 CurrentWorker = NotAWorker;
+        thread_local TaskPriority CurrentPriority = TaskPriority::Normal;
+
+        void UpdatePeak(std::atomic<u64>& peak, u64 value)
+        {
+            u64 current = peak.load(std::memory_order_relaxed);
+            while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed));
+        }
+
+        std::string_view ToString(TaskPriority priority)
+        {
+            switch (priority)
+            {
+                break;case TaskPriority::Interactive: return "interactive";
+                break;case TaskPriority::Normal:      return "normal";
+                break;case TaskPriority::Background:  return "background";
+            }
+            return "unknown";
+        }
+    }
+
+    ThreadPool::ThreadPool(u32 workerCount)
+    {
+        // Keep a second worker on single core machines, so one long task
+        // cannot hold back everything queued behind it
+        if (!workerCount)
+            workerCount = std::max(2u, std::thread::hardware_concurrency());
+
+        workers.reserve(workerCount);
+        for (u32 i = 0; i < workerCount; ++i)
+            workers.emplace_back(std::make_unique<Worker>());
+
+        threads.reserve(workerCount);
+        for (u32 i = 0; i < workerCount; ++i)
+            threads.emplace_back([this, i] { WorkerMain(i); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::scoped_lock lock{ sleepMutex };
+            stopping = true;
+        }
+        wake.notify_all();
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    TaskPriority ThreadPool::GetCurrentPriority()
+    {
+        return CurrentPriority;
+    }
+
+    void ThreadPool::Submit(TaskPriority priority, Task task)
+    {
+        u32 p = u32(priority);
+
+        counters[p].submitted.fetch_add(1, std::memory_order_relaxed);
+        UpdatePeak(counters[p].peakQueued, counters[p].queued.fetch_add(1, std::memory_order_relaxed) + 1);
+
+        // Workers keep their own work local, everyone else injects
+        Deque& queue = CurrentPool == this ? workers[CurrentWorker]->queues[p] : injection[p];
+        {
+            std::scoped_lock lock{ queue.mutex };
+            queue.tasks.push_back(std::move(task));
+        }
+
+        {
+            // Taken briefly so a worker about to sleep cannot miss the task
+            std::scoped_lock lock{ sleepMutex };
+            pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        wake.notify_one();
+    }
+
+    bool ThreadPool::TakeTask(u32 self, TaskPriority minimum, Task& task, TaskPriority& priority)
+    {
+        if (pending.load(std::memory_order_relaxed) <= 0)
+            return false;
+
+        auto take = [&](Deque& queue, bool back) {
+            std::scoped_lock lock{ queue.mutex };
+            if (queue.tasks.empty())
+                return false;
+
+            if (back)
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            return true;
+        };
+
+        // Priorities are scanned from the top before every task, so freshly
+        // submitted interactive work is picked up as soon as any running task
+        // finishes
+
+        for (u32 p = 0; p <= u32(minimum); ++p)
+        {
+            bool found = self != NotAWorker && take(workers[self]->queues[p], true);
+
+            if (!found)
+                found = take(injection[p], false);
+
+            if (!found)
+            {
+                for (u32 i = 1; i <= workers.size() && !found; ++i)
+                {
+                    u32 victim = u32((self + i) % workers.size());
+                    if (victim != self && take(workers[victim]->queues[p], false))
+                    {
+                        counters[p].stolen.fetch_add(1, std::memory_order_relaxed);
+                        found = true;
+                    }
+                }
+            }
+
+            if (found)
+            {
+                pending.fetch_sub(1, std::memory_order_relaxed);
+                counters[p].queued.fetch_sub(1, std::memory_order_relaxed);
+                priority = TaskPriority(p);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void ThreadPool::Execute(Task& task, TaskPriority priority)
+    {
+        TaskPriority previous = CurrentPriority;
+        CurrentPriority = priority;
+        NOVA_DEFER(&) { CurrentPriority = previous; };
+
+        task();
+        task = nullptr;
+
+        counters[u32(priority)].executed.fetch_add(1, std::memory_order_relaxed);
+        if (CurrentPool == this)
+            workers[CurrentWorker]->executed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool ThreadPool::RunPending(TaskPriority minimum)
+    {
+        u32 self = CurrentPool == this ? CurrentWorker : NotAWorker;
+
+        Task task;
+        TaskPriority priority;
+        if (!TakeTask(self, minimum, task, priority))
+            return false;
+
+        Execute(task, priority);
+        return true;
+    }
+
+    void ThreadPool::WorkerMain(u32 index)
+    {
+        CurrentPool = this;
+        CurrentWorker = index;
+
+        Task task;
+        TaskPriority priority;
+        for (;;)
+        {
+            if (TakeTask(index, TaskPriority::Background, task, priority))
+            {
+                Execute(task, priority);
+                continue;
+            }
+
+            std::unique_lock lock{ sleepMutex };
+            wake.wait(lock, [&] { return stopping || pending.load(std::memory_order_relaxed) > 0; });
+            if (stopping)
+                break;
+        }
+    }
+
+    ThreadPoolStats ThreadPool::GetStats() const
+    {
+        ThreadPoolStats stats;
+        for (u32 p = 0; p < TaskPriorityCount; ++p)
+        {
+            auto& in = counters[p];
+            auto& out = stats.queues[p];
+            out.submitted = in.submitted.load(std::memory_order_relaxed);
+            out.executed = in.executed.load(std::memory_order_relaxed);
+            out.stolen = in.stolen.load(std::memory_order_relaxed);
+            out.queued = in.queued.load(std::memory_order_relaxed);
+            out.peakQueued = in.peakQueued.load(std::memory_order_relaxed);
+        }
+
+        stats.executedPerWorker.reserve(workers.size());
+        for (auto& worker : workers)
+            stats.executedPerWorker.push_back(worker->executed.load(std::memory_order_relaxed));
+
+        return stats;
+    }
+
+    void ThreadPool::LogStats() const
+    {
+        auto stats = GetStats();
+        NOVA_LOG("Thread pool: {} workers", workers.size());
+        for (u32 p = 0; p < TaskPriorityCount; ++p)
+        {
+            auto& queue = stats.queues[p];
+            NOVA_LOG("  {:>11}: {} submitted, {} executed, {} stolen, {} queued (peak {})",
+                ToString(TaskPriority(p)), queue.submitted, queue.executed, queue.stolen, queue.queued, queue.peakQueued);
+        }
+
+        std::string perWorker;
+        for (u64 executed : stats.executedPerWorker)
+            perWorker += NOVA_FORMAT(" {}", executed);
+        NOVA_LOG("  per worker:{}", perWorker);
+    }
+
+    ThreadPool& GetThreadPool()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+// -----------------------------------------------------------------------------
+
+    TaskPriorityScope::TaskPriorityScope(TaskPriority priority)
+        : previous(CurrentPriority)
+    {
+        CurrentPriority = priority;
+    }
+
+    TaskPriorityScope::~TaskPriorityScope()
+    {
+        CurrentPriority = previous;
+    }
+
+// -----------------------------------------------------------------------------
+
+    TaskGroup::~TaskGroup()
+    {
+        // Tasks reference the group, never let it go while any are queued
+        try
+        {
+            Wait();
+        }
+        catch (...) {}
+    }
+
+    void TaskGroup::Run(TaskPriority priority, std::function<void()> task)
+    {
+        remaining.fetch_add(1, std::memory_order_relaxed);
+
+        u32 current = lowest.load(std::memory_order_relaxed);
+        while (u32(priority) > current && !lowest.compare_exchange_weak(current, u32(priority), std::memory_order_relaxed));
+
+        GetThreadPool().Submit(priority, [this, task = std::move(task)] {
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                std::scoped_lock lock{ mutex };
+                if (!error)
+                    error = std::current_exception();
+            }
+
+            // The decrement and notify happen under the lock that Wait takes
+            // for its last check, so once Wait returns no task touches the
+            // group again and the owner may destroy it
+            std::scoped_lock lock{ mutex };
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                done.notify_all();
+        });
+    }
+
+    void TaskGroup::Wait()
+    {
+        auto& pool = GetThreadPool();
+
+        // Help out instead of blocking. Only work at least as urgent as the
+        // waiter or its own tasks is taken, so an interactive wait is never
+        // stuck behind a long background task, while a wait on lower
+        // priority tasks can always finish them itself.
+        TaskPriority priority = TaskPriority(std::max(u32(ThreadPool::GetCurrentPriority()), lowest.load(std::memory_order_relaxed)));
+
+        std::exception_ptr rethrow;
+        for (;;)
+        {
+            if (remaining.load(std::memory_order_acquire) && pool.RunPending(priority))
+                continue;
+
+            // The last check is made under the lock, after the final task
+            // has released it
+            std::unique_lock lock{ mutex };
+            if (!remaining.load(std::memory_order_acquire))
+            {
+                std::swap(rethrow, error);
+                break;
+            }
+
+            // Nothing left to help with, the remaining tasks are running.
+            // Poll so that work queued meanwhile still gets helped with.
+            done.wait_for(lock, std::chrono::microseconds(200), [&] {
+                return !remaining.load(std::memory_order_acquire);
+            });
+        }
+
+        if (rethrow)
+            std::rethrow_exception(rethrow);
+    }
+}
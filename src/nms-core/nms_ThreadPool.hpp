@@ -0,0 +1,146 @@
+#pragma once
+
+#include <nova/core/nova_Core.hpp>
+
+using namespace nova::types;
+
+namespace nms
+{
+    // Higher priorities are always taken first. Running tasks are never
+    // interrupted, so long work should be split into short tasks to let
+    // interactive work in between.
+    enum class TaskPriority : u32
+    {
+        Interactive,
+        Normal,
+        Background,
+    };
+
+    constexpr u32 TaskPriorityCount = 3;
+
+    struct ThreadPoolStats
+    {
+        struct Queue
+        {
+            u64 submitted = 0;
+            u64 executed = 0;
+            u64 stolen = 0;
+
+            // Tasks waiting right now and the most ever waiting at once
+            u64 queued = 0;
+            u64 peakQueued = 0;
+        };
+
+        std::array<Queue, TaskPriorityCount> queues;
+        std::vector<u64> executedPerWorker;
+    };
+
+    // Work-stealing scheduler shared by the whole process. Every worker owns
+    // a deque per priority, pushes and pops its own work at the back and
+    // steals from the front of other workers' deques. Threads outside the
+    // pool submit through a shared injection queue per priority.
+
+    class ThreadPool
+    {
+    public:
+        using Task = std::function<void()>;
+
+    private:
+        struct Deque
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        struct Worker
+        {
+            std::array<Deque, TaskPriorityCount> queues;
+            std::atomic<u64> executed = 0;
+        };
+
+        struct QueueCounters
+        {
+            std::atomic<u64> submitted = 0;
+            std::atomic<u64> executed = 0;
+            std::atomic<u64> stolen = 0;
+            std::atomic<u64> queued = 0;
+            std::atomic<u64> peakQueued = 0;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::array<Deque, TaskPriorityCount> injection;
+        std::array<QueueCounters, TaskPriorityCount> counters;
+
+        std::atomic<i64> pending = 0;
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        bool stopping = false;
+
+        std::vector<std::thread> threads;
+
+    public:
+        // Sizes itself to the available cores when workerCount is 0
+        explicit ThreadPool(u32 workerCount = 0);
+        ~ThreadPool();
+
+        u32 Size() const
+        {
+            return u32(workers.size());
+        }
+
+        void Submit(TaskPriority priority, Task task);
+
+        // Runs one queued task of at least the given priority on the calling
+        // thread. Returns false if there was none.
+        bool RunPending(TaskPriority minimum = TaskPriority::Background);
+
+        ThreadPoolStats GetStats() const;
+        void LogStats() const;
+
+        // Priority of the task running on this thread, or the priority set
+        // by TaskPriorityScope outside of tasks. Work submitted without an
+        // explicit priority inherits it.
+        static TaskPriority GetCurrentPriority();
+
+    private:
+        bool TakeTask(u32 self, TaskPriority minimum, Task& task, TaskPriority& priority);
+        void Execute(Task& task, TaskPriority priority);
+        void WorkerMain(u32 index);
+    };
+
+    ThreadPool& GetThreadPool();
+
+    class TaskPriorityScope
+    {
+        TaskPriority previous;
+
+    public:
+        explicit TaskPriorityScope(TaskPriority priority);
+        ~TaskPriorityScope();
+    };
+
+    // Tracks a set of tasks. Waiting runs queued tasks of the same or higher
+    // priority on the calling thread, so waiting inside a task never starves
+    // the pool. The first exception thrown by a task is rethrown by Wait.
+
+    class TaskGroup
+    {
+        std::atomic<u32> remaining = 0;
+        std::atomic<u32> lowest = 0;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+
+    public:
+        ~TaskGroup();
+
+        void Run(TaskPriority priority, std::function<void()> task);
+
+        void Run(std::function<void()> task)
+        {
+            Run(ThreadPool::GetCurrentPriority(), std::move(task));
+        }
+
+        void Wait();
+    };
+}
@@ -1,20 +1,319 @@
 #include <nova/core/nova_Debug.hpp>
-#include <file_searcher.hpp>
+#include <nms-core/nms_Shards.hpp>
+#include <nms-core/nms_Paths.hpp>
+#include <nms-core/nms_Memory.hpp>
+#include <nms-core/nms_ThreadPool.hpp>
+#include <nms-core/nms_IndexReport.hpp>
 
-int main()
+using namespace nova::types;
+
+static void ReportPruned(const nms::ShardConfig& config, const nms::ExclusionRules& exclusions, const std::vector<u64>& pruned)
+{
+    if (pruned.empty())
+        return;
+
+    // Pruned directories count once, their contents are never read
+
+    u64 total = std::accumulate(pruned.begin(), pruned.end(), u64(0));
+    NOVA_LOG("Pruned [{}], {} entries by {} rules", config.name, total, exclusions.Size());
+    for (u32 rule = 0; rule < pruned.size(); ++rule)
+        NOVA_LOG("  {:>10}  {}", pruned[rule], exclusions.GetPattern(rule));
+}
+
+static void ReportEntrySize(const nms::ShardConfig& config, u64 entries, u64 uniqueNames, u64 namesBytes)
+{
+    // Files hold the stored columns only and may be block compressed, while
+    // a loaded index also derives its depth first order, so disk and memory
+    // sizes are reported separately
+
+    std::error_code ec;
+    u64 bytes = std::filesystem::file_size(nms::GetShardFile(config), ec);
+    if (ec || entries == 0)
+        return;
+
+    u64 memoryBytes = entries * nms::Index::EntryBytes + (uniqueNames + 1) * sizeof(u32) + namesBytes;
+
+    NOVA_LOG("Size [{}], {:.1f} MiB on disk, {:.1f} bytes per entry",
+        config.name, f64(bytes) / (1024 * 1024), f64(bytes) / f64(entries));
+    NOVA_LOG("Memory [{}], {:.1f} MiB loaded, {:.1f} bytes per entry ({} in columns + names)",
+        config.name, f64(memoryBytes) / (1024 * 1024), f64(memoryBytes) / f64(entries), nms::Index::EntryBytes);
+    NOVA_LOG("Names [{}], {} distinct, {:.2f} entries per name",
+        config.name, uniqueNames, f64(entries) / f64(std::max<u64>(uniqueNames, 1)));
+}
+
+static void RebuildShard(const nms::ShardConfig& config, u64 memoryBudget, bool quick, const nms::ExclusionRules& exclusions)
+{
+    NOVA_LOG("Indexing [{}] {} to: {}", config.name, config.root.string(), nms::GetShardFile(config).string());
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] {
+        return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    try
+    {
+        if (quick)
+        {
+            nms::Index index;
+            std::vector<u64> pruned;
+            nms::RescanStats stats;
+            if (nms::RescanShard(config, index, &exclusions, &pruned, &stats))
+            {
+                NOVA_LOG("Rescanned [{}], {} entries in {:.2f}s, {} directories checked, {} listed, {} entries reused, {} read",
+                    config.name, index.Size(), elapsed(), stats.directoriesChecked, stats.directoriesListed,
+                    stats.entriesReused, stats.entriesRead);
+            }
+            else
+            {
+                NOVA_LOG("Indexed [{}], {} entries in {:.2f}s, no current index to rescan",
+                    config.name, index.Size(), elapsed());
+            }
+            ReportEntrySize(config, index.Size(), index.NameCount(), index.names.size());
+            ReportPruned(config, exclusions, pruned);
+        }
+        else if (memoryBudget)
+        {
+            nms::ExternalBuildStats stats;
+            nms::BuildShardExternal(config, memoryBudget, &exclusions, &stats);
+
+            NOVA_LOG("Indexed [{}], {} entries in {:.2f}s, {} runs, {} remap passes, process peak memory {:.1f} MiB",
+                config.name, stats.entries, elapsed(), stats.runs, stats.fixupPasses,
+                f64(stats.peakResidentBytes) / (1024 * 1024));
+            ReportEntrySize(config, stats.entries, stats.uniqueNames, stats.namesBytes);
+            ReportPruned(config, exclusions, stats.pruned);
+        }
+        else
+        {
+            nms::Index index;
+            std::vector<u64> pruned;
+            nms::BuildShard(config, index, &exclusions, &pruned);
+
+            NOVA_LOG("Indexed [{}], {} entries in {:.2f}s, process peak memory {:.1f} MiB",
+                config.name, index.Size(), elapsed(),
+                f64(nms::GetPeakResidentBytes()) / (1024 * 1024));
+            ReportEntrySize(config, index.Size(), index.NameCount(), index.names.size());
+            ReportPruned(config, exclusions, pruned);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        NOVA_LOG("Failed to index [{}]: {}", config.name, e.what());
+    }
+}
+
+static void PublishShards()
+{
+    // Running searches reload the shards once the generation changes
+    try
+    {
+        nms::PublishShardGeneration();
+    }
+    catch (const std::exception& e)
+    {
+        NOVA_LOG("Failed to publish shards: {}", e.what());
+    }
+}
+
+static void WriteReport(const std::filesystem::path& output, const std::vector<const nms::ShardConfig*>& configs)
 {
-    std::string index_file = NOVA_FORMAT("{}\\.nms\\index.bin", getenv("USERPROFILE"));
+    std::string json = "{\n  \"generated\": " + std::to_string(nms::GetUnixTime()) + ",\n  \"shards\": [";
+
+    bool first = true;
+    for (auto config : configs)
+    {
+        auto file = nms::GetShardFile(*config);
+        if (!nms::IsIndexFileCurrent(file))
+        {
+            NOVA_LOG("Not reporting [{}], no current index file", config->name);
+            continue;
+        }
+
+        nms::Index index;
+        nms::LoadIndex(index, file);
+        auto report = nms::BuildIndexReport(index);
+
+        std::error_code ec;
+        u64 fileBytes = std::filesystem::file_size(file, ec);
+
+        json += first ? "\n    {\n      \"name\": " : ",\n    {\n      \"name\": ";
+        nms::AppendJsonString(json, config->name);
+        json += ",\n      \"root\": ";
+        nms::AppendJsonString(json, index.root);
+        json += ",\n      \"file\": ";
+        nms::AppendJsonString(json, nms::PathToUtf8(file));
+        json += NOVA_FORMAT(",\n      \"fileBytes\": {},\n      \"encoding\": \"{}\",\n      \"index\": ",
+            fileBytes, config->encoding == nms::IndexEncoding::Blocks ? "blocks" : "raw");
+        nms::AppendIndexReportJson(json, report, 6);
+        json += "\n    }";
+        first = false;
+    }
+    json += first ? "]\n}\n" : "\n  ]\n}\n";
+
+    if (output == "-")
+    {
+        std::cout << json;
+        return;
+    }
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    out.write(json.data(), std::streamsize(json.size()));
+    if (!out)
+        throw std::runtime_error(NOVA_FORMAT("Failed to write report: {}", nms::PathToUtf8(output)));
+    NOVA_LOG("Report written to: {}", nms::PathToUtf8(output));
+}
+
+int main(int argc, char* argv[])
+{
+    bool due = false;
+    bool watch = false;
+    bool wait = true;
+    bool load = false;
+    bool quick = false;
+    u64 memoryBudget = 0;
+    std::filesystem::path reportFile;
+    std::vector<std::string> names;
+
+    for (i32 i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        if (arg == "--due")
+            due = true;
+        else if (arg == "--watch")
+            watch = true;
+        else if (arg == "--no-wait")
+            wait = false;
+        else if (arg == "--memory" && i + 1 < argc)
+            memoryBudget = std::stoull(argv[++i]) * 1024 * 1024;
+        else if (arg == "--report" && i + 1 < argc)
+            reportFile = argv[++i];
+        else if (arg == "--load")
+            load = true;
+        else if (arg == "--quick")
+            quick = true;
+        else if (arg.starts_with("--"))
+        {
+            NOVA_LOG("Usage: nms-index [--due | --watch | --load] [--quick | --memory <MiB>] [--report <file>] [--no-wait] [shard names...]");
+            NOVA_LOG("  Rebuilds the named shards, or all shards by default");
+            NOVA_LOG("  --due    Only rebuild shards whose rebuild interval has elapsed");
+            NOVA_LOG("  --watch  Keep running and rebuild each shard when it is due");
+            NOVA_LOG("  --quick  Only list directories modified since the last build, reusing the rest");
+            NOVA_LOG("  --memory Build each shard through sorted runs on disk within this budget");
+            NOVA_LOG("  --report Write a JSON report of each rebuilt shard's composition, - for stdout");
+            NOVA_LOG("  --load   Report on the existing shard files instead of rebuilding");
+            NOVA_LOG("  Entries matching the rules in exclude.txt in the data directory are skipped");
+            return 1;
+        }
+        else
+            names.emplace_back(arg);
+    }
+
+    // Watched shards never finish rebuilding, so there is no point at which
+    // a report could cover them
+    if (watch && !load && !reportFile.empty())
+    {
+        NOVA_LOG("--report cannot be combined with --watch");
+        return 1;
+    }
+
+    auto configs = nms::LoadShardConfig();
+    auto exclusions = nms::LoadExclusionRules();
+
+    auto named = [&](const nms::ShardConfig& config) {
+        return names.empty() || std::ranges::find(names, config.name) != names.end();
+    };
+
+    auto selected = [&](const nms::ShardConfig& config) {
+        if (!names.empty())
+            return named(config);
+        return load || !due || nms::IsShardDue(config);
+    };
+
+    if (load)
+    {
+        std::vector<const nms::ShardConfig*> reported;
+        for (auto& config : configs)
+        {
+            if (selected(config))
+                reported.push_back(&config);
+        }
+
+        try
+        {
+            WriteReport(reportFile.empty() ? "-" : reportFile, reported);
+        }
+        catch (const std::exception& e)
+        {
+            NOVA_LOG("Failed to write report: {}", e.what());
+            return 1;
+        }
+        return 0;
+    }
+
+    // Each shard is rebuilt as its own task on the shared pool, so a slow
+    // network root does not hold up rebuilding fast local disks. Watched
+    // shards sleep between rebuilds and keep dedicated threads.
+
+    std::vector<std::thread> threads;
+    nms::TaskGroup rebuilds;
+    std::vector<const nms::ShardConfig*> rebuilt;
+    for (auto& config : configs)
+    {
+        if (watch)
+        {
+            // Watch threads check the rebuild interval themselves
+            if (!named(config))
+                continue;
+
+            threads.emplace_back([&config, &exclusions, memoryBudget, quick] {
+                for (;;)
+                {
+                    if (nms::IsShardDue(config))
+                    {
+                        RebuildShard(config, memoryBudget, quick, exclusions);
+                        PublishShards();
+                    }
+                    std::this_thread::sleep_for(std::chrono::minutes(1));
+                }
+            });
+        }
+        else if (selected(config))
+        {
+            rebuilt.push_back(&config);
+            rebuilds.Run(nms::TaskPriority::Background, [&config, &exclusions, memoryBudget, quick] {
+                RebuildShard(config, memoryBudget, quick, exclusions);
+            });
+        }
+        else
+        {
+            NOVA_LOG("Skipping [{}], not due for rebuild", config.name);
+        }
+    }
+
+    rebuilds.Wait();
+    if (!rebuilt.empty())
+        PublishShards();
+
+    for (auto& thread : threads)
+        thread.join();
 
-    NOVA_LOG("Indexing filesystem to: {}", index_file);
+    nms::GetThreadPool().LogStats();
 
-    index_t index;
+    if (!reportFile.empty())
+    {
+        try
+        {
+            WriteReport(reportFile, rebuilt);
+        }
+        catch (const std::exception& e)
+        {
+            NOVA_LOG("Failed to write report: {}", e.what());
+        }
+    }
 
-    index_filesystem(index);
-    NOVA_LOG("Sorting...");
-    sort_index(index);
-    NOVA_LOG("Saving...");
-    save_index(index, index_file.c_str());
-    NOVA_LOG("Indexing complete, Press F5 in NoMoreShortcuts to reload index");
-    NOVA_LOG("Press any key to close..");
-    std::cin.get();
+    NOVA_LOG("Indexing complete, running searches reload the new shards");
+    if (wait)
+    {
+        NOVA_LOG("Press any key to close..");
+        std::cin.get();
+    }
 }
@@ -0,0 +1,159 @@
+#include <nms-core/nms_Paths.hpp>
+#include <nms-core/nms_Protocol.hpp>
+
+#include <nova/core/nova_Debug.hpp>
+
+using namespace nova::types;
+using namespace nms::protocol;
+
+struct QueryClient
+{
+    nms::LocalSocket socket;
+    bool stats = false;
+
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::duration firstPage = {};
+
+    void Send(MessageWriter& writer)
+    {
+        start = std::chrono::steady_clock::now();
+        if (!writer.Send(socket))
+            throw std::runtime_error("Failed to send request");
+    }
+
+    // Reads messages until End, calling onPage for each page payload
+    template<class Fn>
+    void Receive(MessageType pageType, Fn&& onPage)
+    {
+        MessageHeader header;
+        std::vector<u8> payload;
+
+        while (nms::protocol::Receive(socket, header, payload))
+        {
+            MessageReader reader(payload);
+            if (header.type == pageType)
+            {
+                if (firstPage == std::chrono::steady_clock::duration{})
+                    firstPage = std::chrono::steady_clock::now() - start;
+                onPage(reader);
+            }
+            else if (header.type == MessageType::End)
+            {
+                QueryEnd end;
+                if (!Decode(reader, end))
+                    throw std::runtime_error("Malformed query end");
+
+                if (stats)
+                {
+                    using Millis = std::chrono::duration<f64, std::milli>;
+                    auto total = Millis(std::chrono::steady_clock::now() - start).count();
+                    auto service = f64(end.serviceNanos) / 1e6;
+                    std::cerr << NOVA_FORMAT("{} results, round trip {:.3f} ms, first page {:.3f} ms, service {:.3f} ms, overhead {:.3f} ms\n",
+                        end.count, total, Millis(firstPage).count(), service, total - service);
+                }
+                return;
+            }
+            else if (header.type == MessageType::Error)
+            {
+                ErrorMessage error;
+                Decode(reader, error);
+                throw std::runtime_error(error.message);
+            }
+            else
+            {
+                throw std::runtime_error("Unexpected message from daemon");
+            }
+        }
+
+        throw std::runtime_error("Connection closed by daemon");
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        QueryRequest request;
+        auto socketPath = nms::GetDaemonSocketPath();
+        bool stats = false;
+        bool batch = false;
+
+        for (i32 i = 1; i < argc; ++i)
+        {
+            std::string_view arg = argv[i];
+            if (arg == "--limit" && i + 1 < argc)
+                request.limit = u32(std::stoul(argv[++i]));
+            else if (arg == "--page" && i + 1 < argc)
+                request.pageSize = u32(std::stoul(argv[++i]));
+            else if (arg == "--socket" && i + 1 < argc)
+                socketPath = argv[++i];
+            else if (arg == "--stats")
+                stats = true;
+            else if (arg == "--batch")
+                batch = true;
+            else if (arg.starts_with("--"))
+            {
+                NOVA_LOG("Usage: nms-query [--limit <n>] [--page <n>] [--socket <path>] [--stats] <keywords...>");
+                NOVA_LOG("       nms-query --batch [--limit <n per query>] < queries.txt");
+                return 1;
+            }
+            else
+                request.keywords.emplace_back(arg);
+        }
+
+        QueryClient client;
+        client.socket = nms::LocalSocket::Connect(socketPath);
+        client.stats = stats;
+        MessageWriter writer;
+
+        if (batch)
+        {
+            // One query per line, keywords separated by whitespace.
+            // Results are printed as "<query line>\t<path>".
+
+            BatchRequest batchRequest;
+            batchRequest.limit = request.limit;
+            batchRequest.pageSize = request.pageSize;
+
+            std::vector<std::string> lines;
+            std::string line;
+            while (std::getline(std::cin, line))
+            {
+                std::istringstream keywords(line);
+                auto& query = batchRequest.queries.emplace_back();
+                for (std::string keyword; keywords >> keyword;)
+                    query.push_back(std::move(keyword));
+                lines.push_back(std::move(line));
+            }
+
+            Encode(writer, batchRequest);
+            client.Send(writer);
+
+            BatchPage page;
+            client.Receive(MessageType::BatchPage, [&](MessageReader& reader) {
+                if (!Decode(reader, page))
+                    throw std::runtime_error("Malformed batch page");
+                for (auto& result : page.results)
+                    std::cout << lines[result.query] << '\t' << result.path << '\n';
+            });
+        }
+        else
+        {
+            Encode(writer, request);
+            client.Send(writer);
+
+            ResultPage page;
+            client.Receive(MessageType::Page, [&](MessageReader& reader) {
+                if (!Decode(reader, page))
+                    throw std::runtime_error("Malformed result page");
+                for (auto& path : page.paths)
+                    std::cout << path << '\n';
+            });
+        }
+    }
+    catch (const std::exception& e)
+    {
+        NOVA_LOG("Error: {}", e.what());
+        return 1;
+    }
+}
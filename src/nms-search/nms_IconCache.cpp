@@ -0,0 +1,331 @@
+#include "nms_IconCache.hpp"
+
+#include <nms-core/nms_Paths.hpp>
+
+namespace nms
+{
+    static constexpr u32 IconStoreMagic = 0x434D534E; // "NMSC"
+    static constexpr u32 IconStoreVersion = 1;
+
+    // Grows with every distinct per-path icon, start over past this size
+    static constexpr u64 MaxStoreSize = 64ull * 1024 * 1024;
+
+    // Path keys only need to cover the results being browsed
+    static constexpr usz MaxPathKeys = 4096;
+
+    // Store records:
+    //   u32 keySize, key, u64 hash, u32 width, u32 height, width * height * 4 pixels
+    // A width of 0 records that the shell had no icon for the key.
+
+    void IconCache::Init(nova::Context _context, u64 _budget)
+    {
+        context = _context;
+        budget = _budget;
+        storeFile = GetDataDir() / "icons.bin";
+        OpenStore();
+    }
+
+    static bool IsIconStore(std::fstream& in)
+    {
+        u32 magic = 0, version = 0;
+        in.read(reinterpret_cast<c8*>(&magic), sizeof(magic));
+        in.read(reinterpret_cast<c8*>(&version), sizeof(version));
+        return in && magic == IconStoreMagic && version == IconStoreVersion;
+    }
+
+    void IconCache::OpenStore()
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(storeFile.parent_path(), ec);
+
+        store.open(storeFile, std::ios::binary | std::ios::in | std::ios::out);
+        u64 size = std::filesystem::file_size(storeFile, ec);
+        if (!store || ec || size > MaxStoreSize || !IsIconStore(store))
+        {
+            // Missing, outdated or overgrown, start a new store
+
+            store.close();
+            {
+                std::ofstream create(storeFile, std::ios::binary | std::ios::trunc);
+                create.write(reinterpret_cast<const c8*>(&IconStoreMagic), sizeof(IconStoreMagic));
+                create.write(reinterpret_cast<const c8*>(&IconStoreVersion), sizeof(IconStoreVersion));
+            }
+
+            store.open(storeFile, std::ios::binary | std::ios::in | std::ios::out);
+            size = std::filesystem::file_size(storeFile, ec);
+            if (!store || ec || !IsIconStore(store))
+            {
+                NOVA_LOG("Failed to open icon store: {}", storeFile.string());
+                store.close();
+                return;
+            }
+        }
+
+        // Index the records, pixels stay on disk until first drawn. A torn
+        // record from an interrupted write ends the store there.
+
+        storeSize = u64(store.tellg());
+        std::string key;
+        for (;;)
+        {
+            u32 keySize;
+            KeyInfo info;
+            store.read(reinterpret_cast<c8*>(&keySize), sizeof(keySize));
+            if (!store || keySize > 64 * 1024)
+                break;
+
+            key.resize(keySize);
+            store.read(key.data(), keySize);
+            store.read(reinterpret_cast<c8*>(&info.hash), sizeof(info.hash));
+            store.read(reinterpret_cast<c8*>(&info.width), sizeof(info.width));
+            store.read(reinterpret_cast<c8*>(&info.height), sizeof(info.height));
+            if (!store)
+                break;
+
+            info.storeOffset = u64(store.tellg());
+            store.seekg(std::streamoff(u64(info.width) * info.height * 4), std::ios::cur);
+            if (!store || u64(store.tellg()) > size)
+                break;
+
+            keys[key] = info;
+            storeSize = u64(store.tellg());
+        }
+        store.clear();
+
+        NOVA_LOG("Icon store: {} keys, {:.1f} KiB", keys.size(), f64(storeSize) / 1024.0);
+    }
+
+    bool IconCache::ReadStored(const KeyInfo& info)
+    {
+        if (!store.is_open())
+            return false;
+
+        pixels.resize(usz(info.width) * info.height * 4);
+        store.seekg(std::streamoff(info.storeOffset));
+        store.read(reinterpret_cast<c8*>(pixels.data()), std::streamsize(pixels.size()));
+        if (!store)
+        {
+            store.clear();
+            return false;
+        }
+        return true;
+    }
+
+    void IconCache::AppendStored(std::string_view key, KeyInfo& info)
+    {
+        if (!store.is_open())
+            return;
+
+        // Appends overwrite any torn record left at the end
+
+        u32 keySize = u32(key.size());
+        store.seekp(std::streamoff(storeSize));
+        store.write(reinterpret_cast<const c8*>(&keySize), sizeof(keySize));
+        store.write(key.data(), std::streamsize(key.size()));
+        store.write(reinterpret_cast<const c8*>(&info.hash), sizeof(info.hash));
+        store.write(reinterpret_cast<const c8*>(&info.width), sizeof(info.width));
+        store.write(reinterpret_cast<const c8*>(&info.height), sizeof(info.height));
+        info.storeOffset = u64(store.tellp());
+        if (info.width)
+            store.write(reinterpret_cast<const c8*>(pixels.data()), std::streamsize(pixels.size()));
+        store.flush();
+
+        if (store)
+            storeSize = u64(store.tellp());
+        else
+            store.clear();
+    }
+
+// -----------------------------------------------------------------------------
+
+    static bool HasOwnIcon(std::wstring_view extension)
+    {
+        static constexpr std::wstring_view Extensions[] = {
+            L".exe", L".lnk", L".ico", L".url", L".cur", L".ani",
+            L".msc", L".scr", L".cpl", L".appref-ms",
+        };
+
+        for (auto candidate : Extensions)
+        {
+            if (extension.size() == candidate.size()
+                    && CompareStringOrdinal(extension.data(), i32(extension.size()),
+                        candidate.data(), i32(candidate.size()), TRUE) == CSTR_EQUAL)
+                return true;
+        }
+        return false;
+    }
+
+    std::string IconCache::ResolveKey(const std::filesystem::path& path)
+    {
+        // One attribute query decides the key, far cheaper than the shell
+
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+            return "path:" + path.string();
+
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            // Drive roots carry their own icons
+            return path.has_relative_path() ? "dir" : "path:" + path.string();
+        }
+
+        auto extension = path.extension().wstring();
+        if (HasOwnIcon(extension))
+        {
+            u64 modified = u64(data.ftLastWriteTime.dwHighDateTime) << 32 | data.ftLastWriteTime.dwLowDateTime;
+            return NOVA_FORMAT("file:{}@{}", path.string(), modified);
+        }
+
+        CharLowerBuffW(extension.data(), DWORD(extension.size()));
+        return "ext:" + ConvertToString(extension);
+    }
+
+    nova::Image IconCache::Upload(const KeyInfo& info)
+    {
+        auto& texture = textures[info.hash];
+        texture.image = nova::Image::Create(context, Vec3U(info.width, info.height, 0),
+            nova::ImageUsage::Sampled,
+            nova::Format::RGBA8_UNorm);
+
+        texture.image.Set({}, texture.image.Extent(), pixels.data());
+        texture.image.Transition(nova::ImageLayout::Sampled);
+
+        texture.bytes = pixels.size();
+        texture.lastUsedFrame = frame;
+        lru.push_front(info.hash);
+        texture.lru = lru.begin();
+        used += texture.bytes;
+
+        // Evicting erases from the map, which can move this entry
+        auto image = texture.image;
+        Evict();
+        return image;
+    }
+
+    void IconCache::Evict()
+    {
+        while (used > budget && !lru.empty())
+        {
+            auto iter = textures.find(lru.back());
+            if (iter->second.lastUsedFrame == frame)
+                break;
+
+            used -= iter->second.bytes;
+            retired.push_back(std::move(iter->second.image));
+            textures.erase(iter);
+            lru.pop_back();
+        }
+    }
+
+    void IconCache::Load(const std::filesystem::path& path, std::string key)
+    {
+        loading.insert(key);
+        loads.Run(TaskPriority::Background, [this, path, key = std::move(key)]() mutable {
+            LoadedIcon icon{ .key = std::move(key) };
+            if (LoadIconPixels(path.string(), icon.info.width, icon.info.height, icon.pixels))
+            {
+                icon.info.hash = ankerl::unordered_dense::detail::wyhash::hash(icon.pixels.data(), icon.pixels.size());
+            }
+            else
+            {
+                icon.info.width = icon.info.height = 0;
+                icon.pixels.clear();
+            }
+
+            std::scoped_lock lock{ loadedMutex };
+            loaded.emplace_back(std::move(icon));
+        });
+    }
+
+    void IconCache::CollectLoaded()
+    {
+        std::vector<LoadedIcon> icons;
+        {
+            std::scoped_lock lock{ loadedMutex };
+            std::swap(icons, loaded);
+        }
+
+        for (auto& icon : icons)
+        {
+            loading.erase(icon.key);
+
+            std::swap(pixels, icon.pixels);
+            AppendStored(icon.key, icon.info);
+            keys.emplace(std::move(icon.key), icon.info);
+
+            // Fresh icons are about to be drawn, upload while the pixels are at hand
+            if (icon.info.width && !textures.contains(icon.info.hash))
+                Upload(icon.info);
+        }
+    }
+
+    const std::string& IconCache::GetPathKey(const std::filesystem::path& path)
+    {
+        auto pathKey = pathKeys.find(path);
+        if (pathKey == pathKeys.end())
+        {
+            if (pathKeys.size() >= MaxPathKeys)
+                pathKeys.clear();
+            pathKey = pathKeys.emplace(path, ResolveKey(path)).first;
+        }
+
+        return pathKey->second;
+    }
+
+    nova::Image IconCache::Get(const std::filesystem::path& path)
+    {
+        auto& key = GetPathKey(path);
+        auto keyIter = keys.find(key);
+        if (keyIter == keys.end())
+        {
+            if (!loading.contains(key))
+                Load(path, key);
+            return {};
+        }
+
+        auto info = keyIter->second;
+        if (!info.width)
+            return {};
+
+        if (auto texture = textures.find(info.hash); texture != textures.end())
+        {
+            texture->second.lastUsedFrame = frame;
+            lru.splice(lru.begin(), lru, texture->second.lru);
+            return texture->second.image;
+        }
+
+        if (!ReadStored(info))
+            return {};
+
+        return Upload(info);
+    }
+
+    void IconCache::Prefetch(const std::filesystem::path& path)
+    {
+        auto& key = GetPathKey(path);
+        if (!keys.contains(key) && !loading.contains(key))
+            Load(path, key);
+    }
+
+    void IconCache::BeginFrame()
+    {
+        retired.clear();
+        frame++;
+        CollectLoaded();
+    }
+
+    void IconCache::Clear()
+    {
+        loads.Wait();
+        {
+            std::scoped_lock lock{ loadedMutex };
+            loaded.clear();
+        }
+        loading.clear();
+
+        retired.clear();
+        textures.clear();
+        lru.clear();
+        used = 0;
+    }
+}
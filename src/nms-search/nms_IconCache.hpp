@@ -0,0 +1,110 @@
+#pragma once
+
+#include "nms_Platform.hpp"
+
+#include <nms-core/nms_ThreadPool.hpp>
+
+namespace nms
+{
+    // Icons are resolved in three levels, cheapest first:
+    //
+    //  1. Identity: a key naming what the icon depends on. Plain files share
+    //     one key per extension and directories share one key, only files
+    //     that carry their own icon (.exe, .lnk, .ico, ...) are keyed by path
+    //     and modification time.
+    //  2. Textures: a byte-budgeted LRU of GPU images, shared between keys
+    //     with identical pixels.
+    //  3. Store: every resolved key is appended to a single file under the
+    //     data directory, so a restart loads pixels from disk instead of
+    //     asking the shell again.
+    //
+    // Keys missing from the store are loaded from the shell by background
+    // tasks on the shared pool, so typing never waits on icon extraction.
+    // Their icons show up from the frame after they finish.
+
+    class IconCache
+    {
+        struct Texture
+        {
+            nova::Image image;
+            u64 bytes = 0;
+            u64 lastUsedFrame = 0;
+            std::list<u64>::iterator lru;
+        };
+
+        struct KeyInfo
+        {
+            u64 hash = 0;
+            u32 width = 0;
+            u32 height = 0;
+            u64 storeOffset = 0;
+        };
+
+        nova::Context context;
+        u64 budget;
+        u64 used = 0;
+        u64 frame = 0;
+
+        ankerl::unordered_dense::map<std::filesystem::path, std::string> pathKeys;
+        ankerl::unordered_dense::map<std::string, KeyInfo> keys;
+        ankerl::unordered_dense::map<u64, Texture> textures;
+
+        // Most recently used at the front
+        std::list<u64> lru;
+
+        // Evicted textures may still be read by the frame in flight
+        std::vector<nova::Image> retired;
+
+        std::filesystem::path storeFile;
+        std::fstream store;
+        u64 storeSize = 0;
+
+        std::vector<u8> pixels;
+
+        struct LoadedIcon
+        {
+            std::string key;
+            KeyInfo info;
+            std::vector<u8> pixels;
+        };
+
+        // Keys queued with the shell, and the results waiting for BeginFrame
+        ankerl::unordered_dense::set<std::string> loading;
+        std::mutex loadedMutex;
+        std::vector<LoadedIcon> loaded;
+
+        // Declared last, waits for outstanding loads before anything is destroyed
+        TaskGroup loads;
+
+    public:
+        static constexpr u64 DefaultBudget = 32ull * 1024 * 1024;
+
+        void Init(nova::Context context, u64 budget = DefaultBudget);
+
+        // Returns an empty image if there is no icon for the path or it is
+        // still loading. Textures returned this frame are never evicted
+        // before the next BeginFrame.
+        nova::Image Get(const std::filesystem::path& path);
+
+        // Resolves the key of a path about to be shown and queues its load,
+        // without uploading anything
+        void Prefetch(const std::filesystem::path& path);
+
+        // Call once the previous frame has completed on the GPU. Uploads the
+        // icons finished loading since the last frame.
+        void BeginFrame();
+
+        void Clear();
+
+    private:
+        std::string ResolveKey(const std::filesystem::path& path);
+        const std::string& GetPathKey(const std::filesystem::path& path);
+        void OpenStore();
+        bool ReadStored(const KeyInfo& info);
+        void AppendStored(std::string_view key, KeyInfo& info);
+        void Load(const std::filesystem::path& path, std::string key);
+        void CollectLoaded();
+        nova::Image Upload(const KeyInfo& info);
+        void Evict();
+    };
+}
@@ -1,7 +1,6 @@
 #include "nms_Platform.hpp"
 
 #include <nova/core/nova_Guards.hpp>
-#include <nova/core/nova_Stack.hpp>
 
 namespace nms
 {
@@ -25,8 +24,6 @@ namespace nms
     {
         IWICImagingFactory* wic;
 
-        ankerl::unordered_dense::map<u64, nova::Image> imageCache;
-
         ComState()
         {
             CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
@@ -46,17 +43,22 @@ namespace nms
         }
     };
 
-    static ComState NmsComState = {};
-
-    void ClearIconCache()
+    // Icons are loaded from pool threads, each needs its own apartment
+    static ComState& GetComState()
     {
-        NmsComState.imageCache.clear();
+        static thread_local ComState state;
+        return state;
     }
 
-    nova::Image LoadIconFromPath(
-        nova::Context context,
-        std::string_view path)
+    bool LoadIconPixels(
+        std::string_view path,
+        u32& width, u32& height,
+        std::vector<u8>& pixels)
     {
+        // The shell needs COM initialized on the calling thread before any
+        // query, pool threads set it up on their first icon
+        auto& com = GetComState();
+
         // Query shell for path icon
 
         HICON icon = {};
@@ -84,20 +86,19 @@ namespace nms
             icon = info.hIcon;
 
             if (!icon)
-                return {};
+                return false;
         }
 
         // Extract image data from icon
 
         IWICBitmap* bitmap = nullptr;
-        NmsComState.wic->CreateBitmapFromHICON(icon, &bitmap);
+        com.wic->CreateBitmapFromHICON(icon, &bitmap);
         NOVA_DEFER(&) { bitmap->Release(); };
 
-        u32 width, height;
         bitmap->GetSize(&width, &height);
 
         IWICFormatConverter* converter = nullptr;
-        NmsComState.wic->CreateFormatConverter(&converter);
+        com.wic->CreateFormatConverter(&converter);
         NOVA_DEFER(&) { converter->Release(); };
         converter->Initialize(
             bitmap,
@@ -107,26 +108,9 @@ namespace nms
             WICBitmapPaletteTypeMedianCut);
 
         usz dataSize = width * height * 4;
-        auto pixelData = NOVA_STACK_ALLOC(BYTE, dataSize);
-        converter->CopyPixels(nullptr, width * 4, UINT(dataSize), pixelData);
-
-        // Hash and check to find matching existing image
-
-        u64 hash = ankerl::unordered_dense::detail::wyhash::hash(pixelData, dataSize);
-        auto& texture = NmsComState.imageCache[hash];
-        if (texture)
-            return texture;
-
-        NOVA_LOG("Loading icon {}, size = ({}, {})", path, width, height);
-        NOVA_LOG("  Num images = {}", NmsComState.imageCache.size());
-
-        texture = nova::Image::Create(context, Vec3U(width, height, 0),
-            nova::ImageUsage::Sampled,
-            nova::Format::RGBA8_UNorm);
-
-        texture.Set({}, texture.Extent(), pixelData);
-        texture.Transition(nova::ImageLayout::Sampled);
+        pixels.resize(dataSize);
+        converter->CopyPixels(nullptr, width * 4, UINT(dataSize), pixels.data());
 
-        return texture;
+        return true;
     }
 }
\ No newline at end of file
@@ -50,9 +50,11 @@ namespace nms
         return str;
     }
 
-    nova::Image LoadIconFromPath(
-        nova::Context context,
-        std::string_view path);
-
-    void ClearIconCache();
+    // Queries the shell for the icon of path as tightly packed RGBA8 pixels.
+    // Returns false if the shell has no icon for the path. Safe to call from
+    // any thread.
+    bool LoadIconPixels(
+        std::string_view path,
+        u32& width, u32& height,
+        std::vector<u8>& pixels);
 }
\ No newline at end of file
@@ -2,10 +2,12 @@
 
 #include <nova/core/nova_Core.hpp>
 #include <nova/core/nova_Stack.hpp>
+#include <nova/core/nova_Guards.hpp>
 
 #include <nova/db/nova_Sqlite.hpp>
 
-#include <file_searcher.hpp>
+#include <nms-core/nms_Shards.hpp>
+#include <nms-core/nms_ThreadPool.hpp>
 
 using namespace nova::types;
 
@@ -36,6 +38,44 @@ public:
     virtual bool Contains(const ResultItem& item) = 0;
     virtual bool Filter(const ResultItem& item) = 0;
 
+    // Results are listed in descending score, lists without scoring give
+    // every result the same score
+    virtual u32 GetScore(const ResultItem& item)
+    {
+        (void)item;
+        return 0;
+    }
+
+    // First result scoring below score and last result scoring above it,
+    // inclusive also accepts results scoring exactly score. Lists that can
+    // seek by score should override these linear scans.
+
+    virtual std::unique_ptr<ResultItem> FindFirstBelow(u32 score, bool inclusive)
+    {
+        auto item = Next(nullptr);
+        while (item)
+        {
+            u32 s = GetScore(*item);
+            if (inclusive ? s <= score : s < score)
+                break;
+            item = Next(item.get());
+        }
+        return item;
+    }
+
+    virtual std::unique_ptr<ResultItem> FindLastAbove(u32 score, bool inclusive)
+    {
+        auto item = Prev(nullptr);
+        while (item)
+        {
+            u32 s = GetScore(*item);
+            if (inclusive ? s >= score : s > score)
+                break;
+            item = Prev(item.get());
+        }
+        return item;
+    }
+
     virtual ~ResultList() = default;
 };
 
@@ -43,104 +83,223 @@ public:
 
 class ResultListPriorityCollector : public ResultList
 {
-    std::vector<ResultList*> lists;
+    // Lists filter concurrently and each list joins the results as soon as
+    // its own filter completes. Results are merged by score, ties go to the
+    // list added first. Positions are recomputed from the item on every
+    // step, so lists becoming ready between steps never break iteration.
+    //
+    // Filtering never waits for the previous query. Every query bumps the
+    // generation, a list still filtering an older one runs again with the
+    // latest query once it finishes and only becomes ready when its results
+    // match the current generation. At most one filter runs per list.
+
+    struct Source
+    {
+        ResultList* list;
+        std::atomic<bool> ready = true;
+        bool running = false;
+        u64 generation = 0;
+    };
+
+    std::deque<Source> sources;
+
+    // Guards the query, generations and running flags
+    std::mutex mutex;
+    std::vector<std::string> query;
+    u64 generation = 0;
+    std::exception_ptr error;
+
+    std::atomic<u32> completed = 0;
+    u32 polled = 0;
+
+    nms::TaskGroup filters;
 
 public:
     using ResultList::Filter;
 
     ResultListPriorityCollector() {}
 
-    void AddList(ResultList* list)
+    ~ResultListPriorityCollector()
     {
-        lists.push_back(list);
+        filters.Wait();
     }
 
-    void Filter(nova::Span<std::string_view> query)
+    void AddList(ResultList* list)
     {
-        for (auto l : lists)
-            l->Filter(query);
+        sources.emplace_back().list = list;
     }
 
-    std::unique_ptr<ResultItem> Next(const ResultItem* item)
+    void Filter(nova::Span<std::string_view> _query)
     {
-        if (!item)
+        std::scoped_lock lock{ mutex };
+
+        query.assign(_query.begin(), _query.end());
+        generation++;
+
+        for (auto& source : sources)
         {
-            for (auto l : lists)
-            {
-                auto next = l->Next(nullptr);
-                if (next)
-                    return next;
-            }
+            source.ready.store(false, std::memory_order_relaxed);
+            if (source.running)
+                continue;
+
+            source.running = true;
+            filters.Run(nms::TaskPriority::Interactive, [this, &source] {
+                FilterSource(source);
+            });
         }
+    }
 
-        for (i32 i = 0; i < lists.size(); ++i)
+    // True once for every batch of lists that became ready since the last
+    // poll, results should be listed again when it is. Rethrows the first
+    // filter error since the last poll.
+    bool Poll()
+    {
         {
-            auto l = lists[i];
-            if (l->Contains(*item))
-            {
-                auto next = l->Next(item);
-                if (!next)
-                {
-                    if (i + 1 == lists.size())
-                        return nullptr;
-
-                    return lists[i + 1]->Next(nullptr);
-                }
-                return next;
-            }
+            std::scoped_lock lock{ mutex };
+            if (error)
+                std::rethrow_exception(std::exchange(error, nullptr));
         }
-        return nullptr;
+
+        u32 count = completed.load(std::memory_order_acquire);
+        if (count == polled)
+            return false;
+
+        polled = count;
+        return true;
     }
 
-    std::unique_ptr<ResultItem> Prev(const ResultItem* item)
+    // True when no list is filtering, lists may only be changed then
+    bool IsIdle()
     {
-        if (!item)
+        std::scoped_lock lock{ mutex };
+        return std::ranges::none_of(sources, &Source::running);
+    }
+
+    std::unique_ptr<ResultItem> Next(const ResultItem* item)
+    {
+        u32 index = item ? FindList(*item) : u32(sources.size());
+        if (item && index == sources.size())
+            return nullptr;
+
+        u32 score = item ? sources[index].list->GetScore(*item) : 0;
+
+        std::unique_ptr<ResultItem> best;
+        u32 bestScore = 0;
+        for (u32 i = 0; i < sources.size(); ++i)
         {
-            for (auto l = lists.rbegin(); l != lists.rend(); l++)
+            if (!sources[i].ready.load(std::memory_order_acquire))
+                continue;
+
+            // Lists before the item's own list already gave their results
+            // with equal score, lists after it still have theirs to give
+            auto list = sources[i].list;
+            auto next = !item       ? list->Next(nullptr)
+                      : i == index  ? list->Next(item)
+                                    : list->FindFirstBelow(score, i > index);
+            if (!next)
+                continue;
+
+            u32 nextScore = list->GetScore(*next);
+            if (!best || nextScore > bestScore)
             {
-                auto prev = (*l)->Prev(nullptr);
-                if (prev)
-                    return prev;
+                best = std::move(next);
+                bestScore = nextScore;
             }
         }
+        return best;
+    }
 
-        for (i32 i = 0; i < lists.size(); ++i)
+    std::unique_ptr<ResultItem> Prev(const ResultItem* item)
+    {
+        u32 index = item ? FindList(*item) : u32(sources.size());
+        if (item && index == sources.size())
+            return nullptr;
+
+        u32 score = item ? sources[index].list->GetScore(*item) : 0;
+
+        std::unique_ptr<ResultItem> best;
+        u32 bestScore = 0;
+        for (u32 i = u32(sources.size()); i-- > 0;)
         {
-            auto l = lists[i];
-            if (l->Contains(*item))
+            if (!sources[i].ready.load(std::memory_order_acquire))
+                continue;
+
+            auto list = sources[i].list;
+            auto prev = !item       ? list->Prev(nullptr)
+                      : i == index  ? list->Prev(item)
+                                    : list->FindLastAbove(score, i < index);
+            if (!prev)
+                continue;
+
+            u32 prevScore = list->GetScore(*prev);
+            if (!best || prevScore < bestScore)
             {
-                auto prev = l->Prev(item);
-                if (!prev)
-                {
-                    if (i == 0)
-                        return nullptr;
-
-                    return lists[i - 1]->Prev(nullptr);
-                }
-                return prev;
+                best = std::move(prev);
+                bestScore = prevScore;
             }
         }
-        return nullptr;
+        return best;
     }
 
     bool Filter(const ResultItem& item)
     {
-        for (auto l : lists)
-        {
-            if (l->Contains(item))
-                return l->Filter(item);
-        }
-        return false;
+        u32 index = FindList(item);
+        return index < sources.size()
+            && sources[index].ready.load(std::memory_order_acquire)
+            && sources[index].list->Filter(item);
     }
 
     bool Contains(const ResultItem& item)
     {
-        for (auto l : lists)
+        return FindList(item) < sources.size();
+    }
+
+private:
+    // Filters the source until its results match the latest query. Stale
+    // results are dropped without the source ever becoming ready.
+    void FilterSource(Source& source)
+    {
+        std::vector<std::string> snapshot;
+        std::vector<std::string_view> views;
+
+        for (;;)
         {
-            if (l->Contains(item))
-                return true;
+            u64 target;
+            {
+                std::scoped_lock lock{ mutex };
+                if (source.generation == generation)
+                {
+                    source.running = false;
+                    source.ready.store(true, std::memory_order_release);
+                    completed.fetch_add(1, std::memory_order_release);
+                    return;
+                }
+                snapshot = query;
+                target = generation;
+            }
+
+            views.assign(snapshot.begin(), snapshot.end());
+            try
+            {
+                source.list->Filter(nova::Span<std::string_view>(views.data(), views.size()));
+            }
+            catch (...)
+            {
+                // Reported by the next poll
+                std::scoped_lock lock{ mutex };
+                if (!error)
+                    error = std::current_exception();
+            }
+            source.generation = target;
         }
-        return false;
+    }
+
+    u32 FindList(const ResultItem& item)
+    {
+        u32 index = 0;
+        while (index < sources.size() && !sources[index].list->Contains(item))
+            index++;
+        return index;
     }
 };
 
@@ -175,6 +334,9 @@ class FavResultList : public ResultList
 public:
     using ResultList::Filter;
 
+    // Favourites score above every other result, keeping them listed first
+    static constexpr u32 Score = ~0u;
+
     FavResultList()
         : dbName(std::format("{}\\.nms\\app.db", getenv("USERPROFILE")))
     {
@@ -316,6 +478,12 @@ public:
         return dynamic_cast<const FavResultItem*>(&item) != nullptr;
     }
 
+    u32 GetScore(const ResultItem& item) final
+    {
+        (void)item;
+        return Score;
+    }
+
     bool ContainsPath(const std::filesystem::path& path)
     {
         return std::ranges::find_if(favourites,
@@ -331,12 +499,14 @@ class FileResultItem : public ResultItem
 {
     friend class FileResultList;
 
-    usz index;
+    nms::ShardCursor cursor;
+    u32 rank;
     std::filesystem::path path;
 
 public:
-    FileResultItem(std::filesystem::path&& _path, usz _index)
-        : index(_index)
+    FileResultItem(std::filesystem::path&& _path, nms::ShardCursor _cursor, u32 _rank = 0)
+        : cursor(_cursor)
+        , rank(_rank)
         , path(_path)
     {}
 
@@ -348,31 +518,70 @@ public:
 
 class FileResultList : public ResultList
 {
-    file_searcher_t* searcher;
+    std::shared_ptr<nms::ShardSet> shards;
     FavResultList* favourites;
+    bool indexed = false;
+
+    // Scored queries list matches by descending score, ties keep index
+    // order. Items carry their rank in this list.
+    bool scored = false;
+    std::vector<nms::ShardCursor> ranked;
 
 public:
     using ResultList::Filter;
 
-    FileResultList(file_searcher_t* _searcher, FavResultList* _favourites)
-        : searcher(_searcher)
-        , favourites(_favourites)
+    FileResultList(FavResultList* _favourites)
+        : favourites(_favourites)
     {}
 
+    // Results are withheld until shards are set, this allows the list to be
+    // used while the index loads in the background. Shards are replaced
+    // between filters when a reload is swapped in, the list keeps the set
+    // it filters alive.
+    void SetShards(std::shared_ptr<nms::ShardSet> _shards)
+    {
+        shards = std::move(_shards);
+        indexed = bool(shards);
+        scored = false;
+        ranked.clear();
+    }
+
     void Filter(nova::Span<std::string_view> query)
     {
-        NOVA_LOGEXPR(searcher);
-        searcher->filter(query);
+        scored = false;
+        ranked.clear();
+
+        if (!indexed)
+            return;
+
+        shards->Filter(query);
+
+        if (shards->HasScores())
+        {
+            scored = true;
+            for (auto cursor = shards->FindNext({}); cursor.IsValid(); cursor = shards->FindNext(cursor))
+                ranked.push_back(cursor);
+
+            std::ranges::stable_sort(ranked, std::greater{}, [this](nms::ShardCursor cursor) {
+                return shards->GetScore(cursor);
+            });
+        }
     }
 
     std::unique_ptr<ResultItem> Next(const ResultItem* item) override
     {
+        if (!indexed)
+            return nullptr;
+
         auto* current = dynamic_cast<const FileResultItem*>(item);
-        uint32_t i = current ? uint32_t(current->index) : UINT_MAX;
-        while ((i = searcher->find_next_file(i)) != UINT_MAX) {
-            auto path = std::filesystem::path(searcher->index->get_full_path(i));
+        if (scored)
+            return FindRanked(current ? usz(current->rank) + 1 : 0, true);
+
+        auto cursor = current ? current->cursor : nms::ShardCursor{};
+        while ((cursor = shards->FindNext(cursor)).IsValid()) {
+            auto path = std::filesystem::path(shards->GetFullPath(cursor));
             if (!favourites->ContainsPath(path)) {
-                return std::make_unique<FileResultItem>(std::move(path), i);
+                return std::make_unique<FileResultItem>(std::move(path), cursor);
             }
         }
         return nullptr;
@@ -380,12 +589,21 @@ public:
 
     std::unique_ptr<ResultItem> Prev(const ResultItem* item) override
     {
+        if (!indexed)
+            return nullptr;
+
         auto* current = dynamic_cast<const FileResultItem*>(item);
-        uint32_t i = current ? uint32_t(current->index) : UINT_MAX;
-        while ((i = searcher->find_prev_file(i)) != UINT_MAX) {
-            auto path = std::filesystem::path(searcher->index->get_full_path(i));
+        if (scored)
+        {
+            usz end = current ? current->rank : ranked.size();
+            return end ? FindRanked(end - 1, false) : nullptr;
+        }
+
+        auto cursor = current ? current->cursor : nms::ShardCursor{};
+        while ((cursor = shards->FindPrev(cursor)).IsValid()) {
+            auto path = std::filesystem::path(shards->GetFullPath(cursor));
             if (!favourites->ContainsPath(path)) {
-                return std::make_unique<FileResultItem>(std::move(path), i);
+                return std::make_unique<FileResultItem>(std::move(path), cursor);
             }
         }
         return nullptr;
@@ -399,6 +617,57 @@ public:
     bool Filter(const ResultItem& item) override
     {
         auto* current = dynamic_cast<const FileResultItem*>(&item);
-        return current ? searcher->is_matched(uint32_t(current->index)) : false;
+        return (indexed && current) ? shards->IsMatched(current->cursor) : false;
+    }
+
+    u32 GetScore(const ResultItem& item) override
+    {
+        auto* current = dynamic_cast<const FileResultItem*>(&item);
+        return (scored && current) ? shards->GetScore(current->cursor) : 0;
     }
-};
\ No newline at end of file
+
+    std::unique_ptr<ResultItem> FindFirstBelow(u32 score, bool inclusive) override
+    {
+        if (!scored)
+            return (inclusive || score > 0) ? Next(nullptr) : nullptr;
+
+        auto first = std::ranges::partition_point(ranked, [&](nms::ShardCursor cursor) {
+            u32 s = shards->GetScore(cursor);
+            return inclusive ? s > score : s >= score;
+        });
+        return FindRanked(usz(first - ranked.begin()), true);
+    }
+
+    std::unique_ptr<ResultItem> FindLastAbove(u32 score, bool inclusive) override
+    {
+        if (!scored)
+            return (inclusive && score == 0) ? Prev(nullptr) : nullptr;
+
+        auto end = std::ranges::partition_point(ranked, [&](nms::ShardCursor cursor) {
+            u32 s = shards->GetScore(cursor);
+            return inclusive ? s >= score : s > score;
+        });
+        return end != ranked.begin() ? FindRanked(usz(end - ranked.begin()) - 1, false) : nullptr;
+    }
+
+private:
+    // Walks the ranked matches from rank, skipping favourites. The walk
+    // ends after the last rank going forward and after rank 0 going back.
+    std::unique_ptr<ResultItem> FindRanked(usz rank, bool forward)
+    {
+        while (rank < ranked.size())
+        {
+            auto path = std::filesystem::path(shards->GetFullPath(ranked[rank]));
+            if (!favourites->ContainsPath(path))
+                return std::make_unique<FileResultItem>(std::move(path), ranked[rank], u32(rank));
+
+            if (forward)
+                ++rank;
+            else if (rank > 0)
+                --rank;
+            else
+                break;
+        }
+        return nullptr;
+    }
+};
@@ -10,24 +10,6 @@ using namespace std::literals;
 
 App::App()
 {
-    glfwInit();
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_TRANSPARENT_FRAMEBUFFER, GLFW_TRUE);
-    glfwWindowHint(GLFW_DECORATED, GLFW_FALSE);
-    window = glfwCreateWindow(1920, 1200, "No More Shortcuts", nullptr, nullptr);
-
-    HWND hwnd = glfwGetWin32Window(window);
-    SetWindowLongW(hwnd, GWL_EXSTYLE, GetWindowLongW(hwnd, GWL_EXSTYLE) | WS_EX_LAYERED);
-
-    // TODO: Chroma key is an ugly hack, use nchittest to do analytical transparency
-    //   Or, do full screeen pass to filter out unintentional chroma key matches and
-    //   apply chroma key based on alpha.
-    SetLayeredWindowAttributes(hwnd, RGB(0, 1, 0), 0, LWA_COLORKEY);
-
-    context = nova::Context::Create({ .debug = false });
-    queue = context.Queue(nova::QueueFlags::Graphics, 0);
-    imDraw = std::make_unique<nova::draw::Draw2D>(context);
-
     {
         char module_filename[4096];
         GetModuleFileNameA(nullptr, module_filename, sizeof(module_filename));
@@ -36,77 +18,103 @@ App::App()
         NOVA_LOG(" exe dir: {}", exe_dir.string());
     }
 
-    std::filesystem::create_directories(std::filesystem::path(indexFile).parent_path());
+    // Startup is split into stages that run in parallel where possible.
+    // The index is loaded in the background, the window becomes usable
+    // as soon as favourites and rendering resources are ready.
 
-NOVA_DEBUG();
-    searcher.init(context, context.Queue(nova::QueueFlags::Compute, 0));
-NOVA_DEBUG();
+    using enum nms::StageThread;
 
-    {
-        GLFWimage iconImage;
+    indexStage = startup.Add("index", Worker, {}, [this] {
+        LoadIndex();
+    }, true);
 
-        i32 channels;
-        iconImage.pixels = stbi_load("favicon.png", &iconImage.width, &iconImage.height, &channels, STBI_rgb_alpha);
-        NOVA_DEFER(&) { stbi_image_free(iconImage.pixels); };
+    auto windowStage = startup.Add("window", Main, {}, [this] {
+        glfwInit();
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_TRANSPARENT_FRAMEBUFFER, GLFW_TRUE);
+        glfwWindowHint(GLFW_DECORATED, GLFW_FALSE);
+        window = glfwCreateWindow(1920, 1200, "No More Shortcuts", nullptr, nullptr);
 
-        glfwSetWindowIcon(window, 1, &iconImage);
-    }
+        HWND hwnd = glfwGetWin32Window(window);
+        SetWindowLongW(hwnd, GWL_EXSTYLE, GetWindowLongW(hwnd, GWL_EXSTYLE) | WS_EX_LAYERED);
 
-    swapchain = nova::Swapchain::Create(context, glfwGetWin32Window(window),
-        nova::ImageUsage::TransferDst
-        | nova::ImageUsage::ColorAttach,
-        nova::PresentMode::Fifo);
+        // TODO: Chroma key is an ugly hack, use nchittest to do analytical transparency
+        //   Or, do full screeen pass to filter out unintentional chroma key matches and
+        //   apply chroma key based on alpha.
+        SetLayeredWindowAttributes(hwnd, RGB(0, 1, 0), 0, LWA_COLORKEY);
 
-    commandPool = nova::CommandPool::Create(context, queue);
-    fence = nova::Fence::Create(context);
+        {
+            GLFWimage iconImage;
 
-// -----------------------------------------------------------------------------
+            i32 channels;
+            iconImage.pixels = stbi_load("favicon.png", &iconImage.width, &iconImage.height, &channels, STBI_rgb_alpha);
+            NOVA_DEFER(&) { stbi_image_free(iconImage.pixels); };
 
-    i32 count;
-    auto mode = glfwGetVideoMode(glfwGetMonitors(&count)[0]);
-    mWidth = mode->width;
-    mHeight = mode->height;
+            glfwSetWindowIcon(window, 1, &iconImage);
+        }
 
-// -----------------------------------------------------------------------------
+        i32 count;
+        auto mode = glfwGetVideoMode(glfwGetMonitors(&count)[0]);
+        mWidth = mode->width;
+        mHeight = mode->height;
+    });
 
-    font = imDraw->LoadFont("SEGUISB.TTF", 35.f * ui_scale);
-    fontSmall = imDraw->LoadFont("SEGOEUI.TTF", 18.f * ui_scale);
+    auto contextStage = startup.Add("context", Worker, {}, [this] {
+        context = nova::Context::Create({ .debug = false });
+        queue = context.Queue(nova::QueueFlags::Graphics, 0);
+        imDraw = std::make_unique<nova::draw::Draw2D>(context);
+    });
 
-// -----------------------------------------------------------------------------
+    startup.Add("icons", Worker, { contextStage }, [this] {
+        icons.Init(context);
+    });
 
-    keywords.push_back("");
+    startup.Add("fonts", Worker, { contextStage }, [this] {
+        font = imDraw->LoadFont("SEGUISB.TTF", 35.f * ui_scale);
+        fontSmall = imDraw->LoadFont("SEGOEUI.TTF", 18.f * ui_scale);
+    });
 
-    using namespace std::chrono;
+    startup.Add("swapchain", Main, { windowStage, contextStage }, [this] {
+        swapchain = nova::Swapchain::Create(context, glfwGetWin32Window(window),
+            nova::ImageUsage::TransferDst
+            | nova::ImageUsage::ColorAttach,
+            nova::PresentMode::Fifo);
 
-NOVA_DEBUG();
-    resultList = std::make_unique<ResultListPriorityCollector>();
-    favResultList = std::make_unique<FavResultList>();
-    NOVA_LOGEXPR(favResultList);
-    fileResultList = std::make_unique<FileResultList>(&searcher, favResultList.get());
-    resultList->AddList(favResultList.get());
-    resultList->AddList(fileResultList.get());
-NOVA_DEBUG();
+        commandPool = nova::CommandPool::Create(context, queue);
+        fence = nova::Fence::Create(context);
+    });
+
+    startup.Add("favourites", Worker, {}, [this] {
+        resultList = std::make_unique<ResultListPriorityCollector>();
+        favResultList = std::make_unique<FavResultList>();
+        fileResultList = std::make_unique<FileResultList>(favResultList.get());
+        resultList->AddList(favResultList.get());
+        resultList->AddList(fileResultList.get());
+    });
+
+    startup.Run();
+
+// -----------------------------------------------------------------------------
+
+    keywords.push_back("");
 
     show = false;
 
-NOVA_DEBUG();
-    UpdateIndex();
-NOVA_DEBUG();
     ResetItems();
-NOVA_DEBUG();
     UpdateQuery();
-NOVA_DEBUG();
 }
 
 App::~App()
 {
     fence.Wait();
-    nms::ClearIconCache();
+    icons.Clear();
 }
 
 void App::ResetItems(bool end)
 {
     items.clear();
+    ClearPrefetch();
+    layoutCache.clear();
     if (end)
     {
         auto item = resultList->Prev(nullptr);
@@ -168,11 +176,17 @@ std::string App::JoinQuery()
 
 void App::UpdateQuery()
 {
+    queryText = JoinQuery();
+    auto bounds = imDraw->MeasureString(queryText, *font);
+    queryWidth = bounds.Empty() ? 0.f : bounds.Width();
+
     ResetItems();
 }
 
 void App::Move(i32 delta)
 {
+    RecordMove(delta < 0 ? -1 : 1);
+
     auto i = delta;
     if (i < 0)
     {
@@ -202,9 +216,20 @@ bool App::MoveSelectedUp()
     }
     else
     {
-        auto prev = resultList->Prev(items[0].get());
+        std::unique_ptr<ResultItem> prev;
+        if (!behind.empty())
+        {
+            prev = std::move(behind.front());
+            behind.pop_front();
+        }
+        else
+        {
+            prev = resultList->Prev(items[0].get());
+        }
+
         if (prev)
         {
+            ahead.push_front(std::move(items[items.size() - 1]));
             std::rotate(items.rbegin(), items.rbegin() + 1, items.rend());
             items[0] = std::move(prev);
         }
@@ -239,9 +264,20 @@ bool App::MoveSelectedDown()
     }
     else
     {
-        auto next = resultList->Next(items[items.size() - 1].get());
+        std::unique_ptr<ResultItem> next;
+        if (!ahead.empty())
+        {
+            next = std::move(ahead.front());
+            ahead.pop_front();
+        }
+        else
+        {
+            next = resultList->Next(items[items.size() - 1].get());
+        }
+
         if (next)
         {
+            behind.push_front(std::move(items[0]));
             std::rotate(items.begin(), items.begin() + 1, items.end());
             items[items.size() - 1] = std::move(next);
         }
@@ -258,6 +294,161 @@ bool App::MoveSelectedDown()
     return true;
 }
 
+void App::RecordMove(i32 direction)
+{
+    auto now = std::chrono::steady_clock::now();
+    f32 interval = std::chrono::duration<f32>(now - lastMove).count();
+    lastMove = now;
+
+    if (direction != moveDirection || interval > MaxRepeatInterval)
+    {
+        moveDirection = direction;
+        moveInterval = 0.f;
+        return;
+    }
+
+    moveInterval = moveInterval > 0.f
+        ? moveInterval + (interval - moveInterval) * 0.25f
+        : interval;
+}
+
+u32 App::GetPrefetchDepth(i32 direction) const
+{
+    // A page either way covers single steps, held keys look ahead by how far
+    // the selection travels in PrefetchSeconds at the current repeat rate
+
+    if (direction != moveDirection || moveInterval <= 0.f)
+        return VisibleRows;
+
+    f32 rows = PrefetchSeconds / std::max(moveInterval, 0.001f);
+    return u32(std::min(f32(MaxPrefetchRows), f32(VisibleRows) + rows));
+}
+
+void App::ClearPrefetch()
+{
+    ahead.clear();
+    behind.clear();
+    aheadDone = false;
+    behindDone = false;
+}
+
+void App::Prefetch()
+{
+    if (items.size() < VisibleRows)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto fill = [&](std::deque<std::unique_ptr<ResultItem>>& rows, bool& done, bool forward) {
+        // Rows scrolled past pile up on the far side, drop the oldest
+        if (rows.size() > MaxPrefetchRows)
+        {
+            rows.resize(MaxPrefetchRows);
+            done = false;
+        }
+
+        u32 depth = GetPrefetchDepth(forward ? 1 : -1);
+        while (!done && rows.size() < depth
+            && std::chrono::steady_clock::now() - start < PrefetchBudget)
+        {
+            auto last = rows.empty()
+                ? (forward ? items[items.size() - 1] : items[0]).get()
+                : rows.back().get();
+            auto row = forward ? resultList->Next(last) : resultList->Prev(last);
+            if (!row)
+            {
+                done = true;
+                break;
+            }
+
+            // Resolve what drawing the row would otherwise do on the frame
+            // it scrolls in
+            auto& path = row->GetPath();
+            icons.Prefetch(path);
+            if (layoutFont == font.get())
+                GetTextLayout(path, layoutWidth);
+
+            rows.push_back(std::move(row));
+        }
+    };
+
+    if (moveDirection < 0)
+    {
+        fill(behind, behindDone, false);
+        fill(ahead, aheadDone, true);
+    }
+    else
+    {
+        fill(ahead, aheadDone, true);
+        fill(behind, behindDone, false);
+    }
+}
+
+std::string App::EllipsizeMiddle(std::string_view text, f32 maxWidth, nova::draw::Font& textFont)
+{
+    if (imDraw->MeasureString(text, textFont).Width() <= maxWidth)
+        return std::string(text);
+
+    // Binary search for the most characters that fit with the middle cut
+    // out, keeping the start of the path and the tail nearest the file
+
+    auto isContinuation = [&](usz i) { return i < text.size() && (u8(text[i]) & 0xC0) == 0x80; };
+
+    auto build = [&](usz keep) {
+        usz head = (keep + 1) / 2;
+        usz tail = text.size() - (keep - head);
+        while (isContinuation(head)) head--;
+        while (isContinuation(tail)) tail++;
+
+        std::string result;
+        result.reserve(head + 3 + text.size() - tail);
+        result.append(text.substr(0, head));
+        result.append("...");
+        result.append(text.substr(tail));
+        return result;
+    };
+
+    usz low = 0;
+    usz high = text.size() - 1;
+    while (low < high)
+    {
+        usz mid = (low + high + 1) / 2;
+        if (imDraw->MeasureString(build(mid), textFont).Width() <= maxWidth)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    return build(low);
+}
+
+const App::TextLayout& App::GetTextLayout(const std::filesystem::path& path, f32 maxWidth)
+{
+    if (layoutFont != font.get() || layoutWidth != maxWidth)
+    {
+        layoutCache.clear();
+        layoutFont = font.get();
+        layoutWidth = maxWidth;
+    }
+
+    auto iter = layoutCache.find(path);
+    if (iter != layoutCache.end())
+        return iter->second;
+
+    if (layoutCache.size() >= MaxLayouts)
+        layoutCache.clear();
+
+    auto& layout = layoutCache[path];
+    layout.filename = EllipsizeMiddle(
+        path.filename().empty() ? path.string() : path.filename().string(),
+        maxWidth, *font);
+    layout.parent = EllipsizeMiddle(
+        path.has_parent_path() ? path.parent_path().string() : path.string(),
+        maxWidth, *fontSmall);
+
+    return layout;
+}
+
 void App::Draw()
 {
     Vec4 backgroundColor = { 0.1f, 0.1f, 0.1f, 1.f };
@@ -302,16 +493,11 @@ void App::Draw()
 
     // Input text
 
+    if (!queryText.empty())
     {
-        auto query = JoinQuery();
-        auto bounds = imDraw->MeasureString(query, *font);
-
-        if (!bounds.Empty())
-        {
-            imDraw->DrawString(query,
-                pos - Vec2(bounds.Width() * 0.5f, inputTextVOffset),
-                *font);
-        }
+        imDraw->DrawString(queryText,
+            pos - Vec2(queryWidth * 0.5f, inputTextVOffset),
+            *font);
     }
 
     if (items.empty())
@@ -339,25 +525,17 @@ void App::Draw()
         .corner_radius = cornerRadius - borderWidth - highlightInset,
     });
 
+    f32 textWidth = 2.f * hOutputWidth - textSmallInset.x - iconPadding;
+
     for (u32 i = 0; i < outputCount; ++i)
     {
-        auto path = items[i]->GetPath();
+        auto& path = items[i]->GetPath();
+        auto& layout = GetTextLayout(path, textWidth);
 
         // Icon
 
-        IconResult* icon;
-        auto iter = iconCache.find(path);
-        if (iter == iconCache.end())
-        {
-            icon = &iconCache[path];
-            icon->texture = nms::LoadIconFromPath(context, path.string());
-        }
-        else
-        {
-            icon = &iter->second;
-        }
-
-        if (icon->texture)
+        auto icon = icons.Get(path);
+        if (icon)
         {
             imDraw->DrawRect({
                 .center_pos = pos
@@ -366,7 +544,7 @@ void App::Draw()
                 .half_extent = Vec2(iconSize) / 2.f,
 
                 .tex_tint = Vec4(1.f),
-                .tex_idx = icon->texture.Descriptor(),
+                .tex_idx = icon.Descriptor(),
                 .tex_center_pos = { 0.5f, 0.5f },
                 .tex_half_extent = { 0.5f, 0.5f },
             });
@@ -374,10 +552,7 @@ void App::Draw()
 
         // Filename
 
-        imDraw->DrawString(
-            path.filename().empty()
-                ? path.string()
-                : path.filename().string(),
+        imDraw->DrawString(layout.filename,
             pos + Vec2(-hOutputWidth, margin + borderWidth)
                 + Vec2(0.f, outputItemHeight * f32(i))
                 + textInset,
@@ -385,10 +560,7 @@ void App::Draw()
 
         // Path
 
-        imDraw->DrawString(
-            path.has_parent_path()
-                ? path.parent_path().string()
-                : path.string(),
+        imDraw->DrawString(layout.parent,
             pos + Vec2(-hOutputWidth, margin + borderWidth)
                 + Vec2(0.f, outputItemHeight * f32(i))
                 + textSmallInset,
@@ -398,6 +570,9 @@ void App::Draw()
 
 void App::Run()
 {
+    // Filtering runs while the user types, ahead of icon loads and reindexing
+    nms::TaskPriorityScope interactive(nms::TaskPriority::Interactive);
+
     glfwSetWindowUserPointer(window, this);
     glfwSetCharCallback(window, [](auto w, u32 codepoint) {
         auto app = (App*)glfwGetWindowUserPointer(w);
@@ -434,13 +609,25 @@ void App::Run()
             }
             glfwPollEvents();
 
+            PollIndex();
+
+            // Lists filter in the background, show their results as each
+            // one completes
+            if (resultList->Poll())
+                ResetItems();
+
             imDraw->Reset();
             Draw();
 
+            // Spend the wait for the previous frame resolving rows just out
+            // of view
+            Prefetch();
+
             // Wait for frame
 
             fence.Wait();
             commandPool.Reset();
+            icons.BeginFrame();
 
             // Record commands
 
@@ -494,17 +681,70 @@ void App::OnChar(u32 codepoint)
     UpdateQuery();
 }
 
-void App::UpdateIndex()
+void App::LoadIndex()
 {
-    if (std::filesystem::exists(indexFile)) {
-        load_index(index, indexFile.c_str());
-    } else {
-        index_filesystem(index);
-        sort_index(index);
-        save_index(index, indexFile.c_str());
+    shards.Load();
+}
+
+void App::ApplyIndex()
+{
+    fileResultList->SetShards(shards.Get());
+    resultList->FilterStrings(keywords);
+}
+
+void App::PollIndex()
+{
+    // Lists can only change between filters. Rather than blocking the frame
+    // on a filter in flight, the index is applied on a later frame once the
+    // lists are idle.
+
+    if (!resultList->IsIdle())
+        return;
+
+    if (!indexApplied)
+    {
+        if (!startup.IsDone(indexStage))
+            return;
+
+        indexApplied = true;
+
+        // Like the daemon, a missing or unreadable index lists nothing
+        // rather than taking down the app. A later publish by nms-index, or
+        // F5, loads it again.
+        try
+        {
+            startup.Rethrow(indexStage);
+        }
+        catch (const std::exception& e)
+        {
+            NOVA_LOG("Failed to load index: {}", e.what());
+        }
+
+        ApplyIndex();
+        ResetItems();
+        return;
+    }
+
+    // Reloaded shards are swapped in between frames and the current query
+    // runs again against them, the old set is freed once its last filter
+    // lets go
+
+    if (shards.Swap())
+    {
+        ApplyIndex();
+        ResetItems();
+        return;
+    }
+
+    // nms-index publishes a new generation once it has replaced shard files
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastShardCheck >= 1s)
+    {
+        lastShardCheck = now;
+        if (shards.IsOutdated())
+            shards.Reload();
     }
-    searcher.set_index(index);
-    fileResultList->FilterStrings(keywords);
 }
 
 void App::OnKey(u32 key, i32 action, i32 mods)
@@ -620,17 +860,13 @@ void App::OnKey(u32 key, i32 action, i32 mods)
         {
             ::ShellExecuteA(nullptr, "open", (exe_dir / "nms-index.exe").string().c_str(), nullptr, nullptr, SW_SHOW);
         }
-        else
+        else if (indexApplied)
         {
-            resultList = std::make_unique<ResultListPriorityCollector>();
-            favResultList = std::make_unique<FavResultList>();
-            fileResultList = std::make_unique<FileResultList>(&searcher, favResultList.get());
-            resultList->AddList(favResultList.get());
-            resultList->AddList(fileResultList.get());
-
-            UpdateIndex();
+            // Favourites are small and reload in place, shards load in the
+            // background and PollIndex swaps them in when ready
+            favResultList->Load();
+            shards.Reload();
             ResetItems();
-            UpdateQuery();
         }
     }
 }
@@ -3,6 +3,8 @@
 #include "nms_Query.hpp"
 
 #include "nms_Platform.hpp"
+#include "nms_IconCache.hpp"
+#include "nms_Startup.hpp"
 
 using namespace nova::types;
 
@@ -25,25 +27,62 @@ public:
 
     std::vector<std::string> keywords;
 
+    static constexpr u32 VisibleRows = 5;
+
     std::vector<std::unique_ptr<ResultItem>> items;
     u32 selection;
 
+    // Rows resolved past either end of the visible items, nearest first.
+    // Idle frames fill these so scrolling takes its next row from here
+    // instead of walking the result lists while a key repeats. The done
+    // flags mark a far end that reached the end of the results.
+
+    static constexpr u32 MaxPrefetchRows = 64;
+    static constexpr f32 PrefetchSeconds = 1.f;
+    static constexpr f32 MaxRepeatInterval = 0.5f;
+    static constexpr std::chrono::microseconds PrefetchBudget{ 2000 };
+
+    std::deque<std::unique_ptr<ResultItem>> ahead;
+    std::deque<std::unique_ptr<ResultItem>> behind;
+    bool aheadDone = false;
+    bool behindDone = false;
+
+    // Smoothed interval between repeated moves in one direction, zero for
+    // single steps. Sets how many rows are kept ready in that direction.
+    std::chrono::time_point<std::chrono::steady_clock> lastMove;
+    f32 moveInterval = 0.f;
+    i32 moveDirection = 0;
+
     std::filesystem::path exe_dir;
 
-    std::string indexFile = std::format("{}\\.nms\\index.bin", getenv("USERPROFILE"));
-    index_t index;
-    file_searcher_t searcher;
+    nms::ShardSetBuffer shards;
+    std::chrono::time_point<std::chrono::steady_clock> lastShardCheck;
 
     std::unique_ptr<FileResultList> fileResultList;
     std::unique_ptr<FavResultList> favResultList;
     std::unique_ptr<ResultListPriorityCollector> resultList;
 
-    struct IconResult
+    nms::IconCache icons;
+
+    // Row text is laid out once per path and reused every frame, the whole
+    // cache is dropped when the fonts or the row width change. Layouts only
+    // need to cover the visible and prefetched rows, so scrolling far drops
+    // the cache as well.
+
+    static constexpr usz MaxLayouts = 4 * (VisibleRows + 2 * MaxPrefetchRows);
+
+    struct TextLayout
     {
-        nova::Image texture = {};
+        std::string filename;
+        std::string parent;
     };
 
-    ankerl::unordered_dense::map<std::filesystem::path, IconResult> iconCache;
+    ankerl::unordered_dense::map<std::filesystem::path, TextLayout> layoutCache;
+    const nova::draw::Font* layoutFont = nullptr;
+    f32 layoutWidth = 0.f;
+
+    std::string queryText;
+    f32 queryWidth = 0.f;
 
     bool show;
     bool running = true;
@@ -53,11 +92,17 @@ public:
     i32 updates = 0;
     std::chrono::time_point<std::chrono::steady_clock> last_update;
 
+    nms::StartupGraph startup;
+    u32 indexStage = 0;
+    bool indexApplied = false;
+
     App();
     ~App();
 
     void ResetItems(bool end = false);
 
+    std::string EllipsizeMiddle(std::string_view text, f32 maxWidth, nova::draw::Font& textFont);
+    const TextLayout& GetTextLayout(const std::filesystem::path& path, f32 maxWidth);
     void Draw();
 
     void ResetQuery();
@@ -68,10 +113,17 @@ public:
     bool MoveSelectedUp();
     bool MoveSelectedDown();
 
+    void RecordMove(i32 direction);
+    u32 GetPrefetchDepth(i32 direction) const;
+    void ClearPrefetch();
+    void Prefetch();
+
     void OnChar(u32 codepoint);
     void OnKey(u32 key, i32 action, i32 mods);
 
-    void UpdateIndex();
+    void LoadIndex();
+    void ApplyIndex();
+    void PollIndex();
 
     void Run();
 };
@@ -0,0 +1,197 @@
+#include "nms_Startup.hpp"
+
+#include <nova/core/nova_Debug.hpp>
+
+namespace nms
+{
+    StartupGraph::~StartupGraph()
+    {
+        workers.Wait();
+    }
+
+    u32 StartupGraph::Add(std::string name, StageThread thread, std::vector<u32> dependencies, std::function<void()> task, bool background)
+    {
+        // Only Run launches stages and it returns once the foreground is
+        // done, so a background stage must become ready by then and must
+        // not hold up Run on the main thread
+
+        if (background && thread == StageThread::Main)
+            throw std::runtime_error(NOVA_FORMAT("Startup stage [{}] cannot run in the background on the main thread", name));
+
+        for (auto dependency : dependencies)
+        {
+            if (background && stages[dependency]->background)
+                throw std::runtime_error(NOVA_FORMAT("Background startup stage [{}] cannot depend on background stage [{}]",
+                    name, stages[dependency]->name));
+        }
+
+        auto stage = std::make_unique<Stage>();
+        stage->name = std::move(name);
+        stage->thread = thread;
+        stage->background = background;
+        stage->dependencies = std::move(dependencies);
+        stage->task = std::move(task);
+        stages.push_back(std::move(stage));
+        return u32(stages.size() - 1);
+    }
+
+    bool StartupGraph::IsReady(const Stage& stage) const
+    {
+        for (auto dependency : stage.dependencies)
+        {
+            if (!stages[dependency]->done)
+                return false;
+        }
+        return true;
+    }
+
+    bool StartupGraph::IsDone(u32 stage) const
+    {
+        return stages[stage]->done;
+    }
+
+    void StartupGraph::Rethrow(u32 stage) const
+    {
+        if (stages[stage]->error)
+            std::rethrow_exception(stages[stage]->error);
+    }
+
+    f64 StartupGraph::Millis(Clock::time_point time) const
+    {
+        return std::chrono::duration<f64, std::milli>(time - epoch).count();
+    }
+
+    u32 StartupGraph::CountDone() const
+    {
+        u32 count = 0;
+        for (auto& stage : stages)
+            count += stage->done;
+        return count;
+    }
+
+    void StartupGraph::Execute(Stage& stage)
+    {
+        // Stages with failed dependencies inherit the failure instead of running
+
+        for (auto dependency : stage.dependencies)
+        {
+            if (stages[dependency]->error)
+                stage.error = stages[dependency]->error;
+        }
+
+        if (!stage.error)
+        {
+            try
+            {
+                stage.task();
+            }
+            catch (...)
+            {
+                stage.error = std::current_exception();
+            }
+        }
+        stage.end = Clock::now();
+
+        if (stage.background)
+        {
+            NOVA_LOG("Startup stage [{}] completed in {:.2f} ms, {:.2f} ms after launch",
+                stage.name, Millis(stage.end) - Millis(stage.begin), Millis(stage.end));
+        }
+
+        {
+            std::scoped_lock lock{ mutex };
+            stage.done = true;
+        }
+        completed.notify_all();
+    }
+
+    void StartupGraph::Launch(Stage& stage)
+    {
+        stage.started = true;
+        stage.begin = Clock::now();
+        if (stage.thread == StageThread::Main)
+        {
+            Execute(stage);
+        }
+        else
+        {
+            // Foreground stages gate time-to-interactive
+            auto priority = stage.background ? TaskPriority::Normal : TaskPriority::Interactive;
+            workers.Run(priority, [this, &stage] {
+                Execute(stage);
+            });
+        }
+    }
+
+    void StartupGraph::Run()
+    {
+        for (;;)
+        {
+            u32 doneCount;
+            {
+                std::scoped_lock lock{ mutex };
+                doneCount = CountDone();
+            }
+
+            bool pending = false;
+            bool progress = false;
+
+            for (auto& stage : stages)
+            {
+                if (stage->started)
+                {
+                    if (!stage->done && !stage->background)
+                        pending = true;
+                    continue;
+                }
+
+                if (IsReady(*stage))
+                {
+                    Launch(*stage);
+                    progress = true;
+                }
+
+                if (!stage->background)
+                    pending = true;
+            }
+
+            if (!pending)
+                break;
+
+            if (!progress)
+            {
+                // Wait for any worker to finish before re-scanning, Main stages
+                // whose dependencies become ready will be picked up on wake.
+
+                std::unique_lock lock{ mutex };
+                completed.wait(lock, [&] { return CountDone() != doneCount; });
+            }
+        }
+
+        for (auto& stage : stages)
+        {
+            if (!stage->background && stage->error)
+                std::rethrow_exception(stage->error);
+        }
+
+        // Report
+
+        auto interactive = Clock::now();
+        NOVA_LOG("Interactive after {:.2f} ms", Millis(interactive));
+        for (auto& stage : stages)
+        {
+            if (stage->background)
+            {
+                NOVA_LOG("  {:<12} {:>9.2f} ms -> background",
+                    stage->name, Millis(stage->begin));
+            }
+            else
+            {
+                NOVA_LOG("  {:<12} {:>9.2f} ms -> {:>9.2f} ms ({:.2f} ms, {})",
+                    stage->name, Millis(stage->begin), Millis(stage->end),
+                    Millis(stage->end) - Millis(stage->begin),
+                    stage->thread == StageThread::Main ? "main" : "worker");
+            }
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <nms-core/nms_ThreadPool.hpp>
+
+namespace nms
+{
+    enum class StageThread
+    {
+        Main,
+        Worker,
+    };
+
+    class StartupGraph
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct Stage
+        {
+            std::string name;
+            StageThread thread;
+            bool background;
+            std::vector<u32> dependencies;
+            std::function<void()> task;
+
+            bool started = false;
+            std::atomic<bool> done = false;
+            std::exception_ptr error;
+
+            Clock::time_point begin;
+            Clock::time_point end;
+        };
+
+        Clock::time_point epoch = Clock::now();
+        std::vector<std::unique_ptr<Stage>> stages;
+
+        std::mutex mutex;
+        std::condition_variable completed;
+
+        // Worker stages run on the shared thread pool
+        TaskGroup workers;
+
+    public:
+        ~StartupGraph();
+
+        // Adds a stage that runs once all dependencies have completed.
+        // Background stages are launched by Run but are not waited on,
+        // poll them with IsDone and collect errors with Rethrow. They must
+        // run on workers and may only depend on foreground stages.
+        u32 Add(std::string name, StageThread thread, std::vector<u32> dependencies, std::function<void()> task, bool background = false);
+
+        // Runs all foreground stages to completion, executing Main stages
+        // on the calling thread, and reports time-to-interactive.
+        void Run();
+
+        bool IsDone(u32 stage) const;
+        void Rethrow(u32 stage) const;
+
+    private:
+        bool IsReady(const Stage& stage) const;
+        void Launch(Stage& stage);
+        void Execute(Stage& stage);
+        u32 CountDone() const;
+        f64 Millis(Clock::time_point time) const;
+    };
+}
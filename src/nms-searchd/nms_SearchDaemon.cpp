@@ -0,0 +1,279 @@
+#include <nms-core/nms_Shards.hpp>
+#include <nms-core/nms_BatchSearch.hpp>
+#include <nms-core/nms_Paths.hpp>
+#include <nms-core/nms_Protocol.hpp>
+#include <nms-core/nms_ThreadPool.hpp>
+
+#include <nova/core/nova_Debug.hpp>
+
+using namespace nova::types;
+
+struct SearchDaemon
+{
+    // Each request works on the set current when it arrived, which stays
+    // alive until the request is done even if a reload swaps it out
+    nms::ShardSetBuffer shards;
+
+    // The searchers hold per-query match state, so filtering is serialized.
+    // Result paths are resolved outside the lock as the shards are immutable.
+    std::mutex searchMutex;
+
+    void HandleQuery(nms::LocalSocket& client, nms::protocol::MessageReader& reader)
+    {
+        using namespace nms::protocol;
+
+        auto start = std::chrono::steady_clock::now();
+
+        MessageWriter writer;
+
+        QueryRequest request;
+        if (!Decode(reader, request))
+        {
+            Encode(writer, ErrorMessage { .id = request.id, .message = "Malformed query" });
+            writer.Send(client);
+            return;
+        }
+
+        auto shards = this->shards.Get();
+
+        std::vector<nms::ShardCursor> entries;
+        {
+            std::vector<std::string_view> keywords;
+            for (auto& keyword : request.keywords)
+            {
+                if (!keyword.empty())
+                    keywords.push_back(keyword);
+            }
+
+            std::scoped_lock lock{ searchMutex };
+            shards->Filter(keywords);
+
+            // Scored queries return the best matches first, which needs every
+            // match before the limit applies. Ties keep index order.
+
+            bool scored = shards->HasScores();
+            for (auto cursor = shards->FindNext({});
+                    cursor.IsValid() && (scored || entries.size() < request.limit);
+                    cursor = shards->FindNext(cursor))
+                entries.push_back(cursor);
+
+            if (scored)
+            {
+                std::vector<std::pair<u32, u32>> ranked(entries.size());
+                for (u32 i = 0; i < entries.size(); ++i)
+                    ranked[i] = { shards->GetScore(entries[i]), i };
+
+                usz count = std::min<usz>(ranked.size(), request.limit);
+                std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), [](auto& l, auto& r) {
+                    return l.first != r.first ? l.first > r.first : l.second < r.second;
+                });
+
+                std::vector<nms::ShardCursor> best(count);
+                for (usz i = 0; i < count; ++i)
+                    best[i] = entries[ranked[i].second];
+                entries = std::move(best);
+            }
+        }
+
+        // Stream results back in pages so clients can display the first
+        // results before the full set has been resolved
+
+        u32 pageSize = std::max(request.pageSize, 1u);
+        ResultPage page;
+        page.id = request.id;
+        for (usz i = 0; i < entries.size(); ++i)
+        {
+            page.paths.push_back(shards->GetFullPath(entries[i]));
+            if (page.paths.size() == pageSize || i + 1 == entries.size())
+            {
+                Encode(writer, page);
+                if (!writer.Send(client))
+                    return;
+                page.paths.clear();
+            }
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Encode(writer, QueryEnd {
+            .id = request.id,
+            .count = u32(entries.size()),
+            .serviceNanos = u64(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+        });
+        writer.Send(client);
+    }
+
+    void HandleBatch(nms::LocalSocket& client, nms::protocol::MessageReader& reader)
+    {
+        using namespace nms::protocol;
+
+        auto start = std::chrono::steady_clock::now();
+
+        MessageWriter writer;
+
+        BatchRequest request;
+        if (!Decode(reader, request))
+        {
+            Encode(writer, ErrorMessage { .id = request.id, .message = "Malformed batch" });
+            writer.Send(client);
+            return;
+        }
+
+        // Batches run lock free, they do not touch the shared searcher state.
+        // Each shard is searched on its own, results are listed per query in
+        // shard order.
+
+        auto shards = this->shards.Get();
+
+        std::vector<std::vector<std::vector<u32>>> results(shards->Size());
+        for (u32 shard = 0; shard < shards->Size(); ++shard)
+            nms::BatchSearch((*shards)[shard].index, request.queries, results[shard], request.limit);
+
+        u32 pageSize = std::max(request.pageSize, 1u);
+        u32 total = 0;
+        BatchPage page;
+        page.id = request.id;
+        for (u32 q = 0; q < request.queries.size(); ++q)
+        {
+            u32 count = 0;
+            for (u32 shard = 0; shard < shards->Size(); ++shard)
+            {
+                for (u32 entry : results[shard][q])
+                {
+                    if (count++ >= request.limit)
+                        break;
+
+                    page.results.push_back({ q, (*shards)[shard].index.GetFullPath(entry) });
+                    total++;
+                    if (page.results.size() == pageSize)
+                    {
+                        Encode(writer, page);
+                        if (!writer.Send(client))
+                            return;
+                        page.results.clear();
+                    }
+                }
+            }
+        }
+
+        if (!page.results.empty())
+        {
+            Encode(writer, page);
+            if (!writer.Send(client))
+                return;
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Encode(writer, QueryEnd {
+            .id = request.id,
+            .count = total,
+            .serviceNanos = u64(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+        });
+        writer.Send(client);
+    }
+
+    void Serve(nms::LocalSocket client)
+    {
+        using namespace nms::protocol;
+
+        // Clients wait on every answer, their filter work goes ahead of
+        // anything queued in the background
+        nms::TaskPriorityScope interactive(nms::TaskPriority::Interactive);
+
+        MessageHeader header;
+        std::vector<u8> payload;
+        while (Receive(client, header, payload))
+        {
+            MessageReader reader(payload);
+            switch (header.type)
+            {
+            break;case MessageType::Query:
+                HandleQuery(client, reader);
+            break;case MessageType::Batch:
+                HandleBatch(client, reader);
+            break;default:
+                NOVA_LOG("Unexpected message type {}", u32(header.type));
+                return;
+            }
+        }
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        auto socketPath = nms::GetDaemonSocketPath();
+        bool reindex = false;
+
+        for (i32 i = 1; i < argc; ++i)
+        {
+            std::string_view arg = argv[i];
+            if (arg == "--socket" && i + 1 < argc)
+                socketPath = argv[++i];
+            else if (arg == "--reindex")
+                reindex = true;
+            else
+            {
+                NOVA_LOG("Usage: nms-searchd [--socket <path>] [--reindex]");
+                return 1;
+            }
+        }
+
+        if (reindex)
+        {
+            auto exclusions = nms::LoadExclusionRules();
+            for (auto& config : nms::LoadShardConfig())
+            {
+                NOVA_LOG("Indexing [{}] {}", config.name, config.root.string());
+                nms::Index index;
+                nms::BuildShard(config, index, &exclusions);
+            }
+        }
+
+        // Shared with the reload and client threads, which are detached and
+        // may outlive this scope
+        auto daemon = std::make_shared<SearchDaemon>();
+        daemon->shards.Load();
+        auto logShards = [](const nms::ShardSet& shards) {
+            for (u32 shard = 0; shard < shards.Size(); ++shard)
+            {
+                auto& [config, index, searcher] = shards[shard];
+                NOVA_LOG("Shard [{}] {}, {} entries", config.name, config.root.string(), index.Size());
+            }
+        };
+        logShards(*daemon->shards.Get());
+
+        // Shards republished by nms-index load in the background while
+        // queries carry on against the current set, then swap in
+        std::thread([daemon, logShards] {
+            for (;;)
+            {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                if (auto shards = daemon->shards.Swap())
+                {
+                    NOVA_LOG("Reloaded shards");
+                    logShards(*shards);
+                }
+                else if (daemon->shards.IsOutdated())
+                {
+                    daemon->shards.Reload();
+                }
+            }
+        }).detach();
+
+        auto listener = nms::LocalSocket::Listen(socketPath);
+        NOVA_LOG("Listening on: {}", socketPath.string());
+
+        while (auto client = listener.Accept())
+        {
+            std::thread([daemon, client = std::move(client)]() mutable {
+                daemon->Serve(std::move(client));
+            }).detach();
+        }
+    }
+    catch (const std::exception& e)
+    {
+        NOVA_LOG("Error: {}", e.what());
+        return 1;
+    }
+}